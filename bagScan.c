@@ -0,0 +1,303 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: bagScan.c
+*
+* Solution description: Find, count and remove all over an
+* array of ints, once per instruction set.  Each version is
+* compiled for its own target with a function attribute, so
+* the file builds without -mavx2 and the choice between them
+* is made at run time from cpuid, once, on the first call.
+* Find stops at the first vector with a match; count adds up
+* the all-ones lanes of each compare; remove all stores whole
+* vectors that hold no match (AVX-512 compresses the kept
+* lanes instead), falling back to a lane at a time for the
+* rare vector that does.
+************************************************************/
+
+#include "bagScan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+# define BAG_SCAN_X86
+# include <immintrin.h>
+#endif
+
+/* One implementation of the three scans */
+struct BagKernels {
+	const char *name;
+	int (*find)(const int *values, int n, int value);
+	int (*count)(const int *values, int n, int value);
+	int (*removeAll)(int *values, int n, int value);
+};
+
+/*----------------------------------------------------------------------------*/
+/* Plain loops, also used for the tails the vector loops leave */
+
+int _findScalar(const int *values, int n, int value)
+{
+    for (int i = 0; i < n; i++) {
+        if (values[i] == value) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int _countScalar(const int *values, int n, int value)
+{
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += (values[i] == value);
+    }
+    return count;
+}
+
+int _removeAllScalar(int *values, int n, int value)
+{
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (values[i] != value) {
+            values[kept++] = values[i];
+        }
+    }
+    return kept;
+}
+
+#ifdef BAG_SCAN_X86
+/*----------------------------------------------------------------------------*/
+/* SSE2, 4 values at a time */
+
+__attribute__((target("sse2")))
+int _findSse2(const int *values, int n, int value)
+{
+    __m128i key = _mm_set1_epi32(value);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(values + i)), key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    int j = _findScalar(values + i, n - i, value);
+    return (j < 0) ? -1 : i + j;
+}
+
+__attribute__((target("sse2")))
+int _countSse2(const int *values, int n, int value)
+{
+    __m128i key = _mm_set1_epi32(value);
+    __m128i sum = _mm_setzero_si128();
+    int i = 0;
+    //a match compares as -1 in its lane
+    for (; i + 4 <= n; i += 4) {
+        sum = _mm_sub_epi32(sum, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(values + i)), key));
+    }
+    int lanes[4];
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + _countScalar(values + i, n - i, value);
+}
+
+__attribute__((target("sse2")))
+int _removeAllSse2(int *values, int n, int value)
+{
+    __m128i key = _mm_set1_epi32(value);
+    int kept = 0, i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, key)));
+        //kept never passes i, so the store only covers values already read
+        if (mask == 0) {
+            _mm_storeu_si128((__m128i *)(values + kept), v);
+            kept += 4;
+            continue;
+        }
+        int lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, v);
+        for (int j = 0; j < 4; j++) {
+            if (!(mask & (1 << j))) {
+                values[kept++] = lanes[j];
+            }
+        }
+    }
+    for (; i < n; i++) {
+        if (values[i] != value) {
+            values[kept++] = values[i];
+        }
+    }
+    return kept;
+}
+
+/*----------------------------------------------------------------------------*/
+/* AVX2, 8 values at a time */
+
+__attribute__((target("avx2")))
+int _findAvx2(const int *values, int n, int value)
+{
+    __m256i key = _mm256_set1_epi32(value);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i)), key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    int j = _findSse2(values + i, n - i, value);
+    return (j < 0) ? -1 : i + j;
+}
+
+__attribute__((target("avx2")))
+int _countAvx2(const int *values, int n, int value)
+{
+    __m256i key = _mm256_set1_epi32(value);
+    __m256i sum = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum = _mm256_sub_epi32(sum, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(values + i)), key));
+    }
+    int lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+    int count = 0;
+    for (int j = 0; j < 8; j++) {
+        count += lanes[j];
+    }
+    return count + _countSse2(values + i, n - i, value);
+}
+
+__attribute__((target("avx2")))
+int _removeAllAvx2(int *values, int n, int value)
+{
+    __m256i key = _mm256_set1_epi32(value);
+    int kept = 0, i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, key)));
+        if (mask == 0) {
+            _mm256_storeu_si256((__m256i *)(values + kept), v);
+            kept += 8;
+            continue;
+        }
+        int lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, v);
+        for (int j = 0; j < 8; j++) {
+            if (!(mask & (1 << j))) {
+                values[kept++] = lanes[j];
+            }
+        }
+    }
+    for (; i < n; i++) {
+        if (values[i] != value) {
+            values[kept++] = values[i];
+        }
+    }
+    return kept;
+}
+
+/*----------------------------------------------------------------------------*/
+/* AVX-512, 16 values at a time; masked loads cover the tail, as the lanes
+   past the end are never read */
+
+__attribute__((target("avx512f")))
+int _findAvx512(const int *values, int n, int value)
+{
+    __m512i key = _mm512_set1_epi32(value);
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 load = (n - i >= 16) ? 0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(load, values + i);
+        __mmask16 eq = _mm512_mask_cmpeq_epi32_mask(load, v, key);
+        if (eq != 0) {
+            return i + __builtin_ctz(eq);
+        }
+    }
+    return -1;
+}
+
+__attribute__((target("avx512f")))
+int _countAvx512(const int *values, int n, int value)
+{
+    __m512i key = _mm512_set1_epi32(value);
+    int count = 0;
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 load = (n - i >= 16) ? 0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(load, values + i);
+        count += __builtin_popcount(_mm512_mask_cmpeq_epi32_mask(load, v, key));
+    }
+    return count;
+}
+
+__attribute__((target("avx512f")))
+int _removeAllAvx512(int *values, int n, int value)
+{
+    __m512i key = _mm512_set1_epi32(value);
+    int kept = 0;
+    for (int i = 0; i < n; i += 16) {
+        __mmask16 load = (n - i >= 16) ? 0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(load, values + i);
+        __mmask16 keep = _mm512_mask_cmpneq_epi32_mask(load, v, key);
+        //the kept lanes are packed together and stored at kept
+        _mm512_mask_compressstoreu_epi32(values + kept, keep, v);
+        kept += __builtin_popcount(keep);
+    }
+    return kept;
+}
+#endif
+
+/*----------------------------------------------------------------------------*/
+static const struct BagKernels scalarKernels =
+	{ "scalar", _findScalar, _countScalar, _removeAllScalar };
+#ifdef BAG_SCAN_X86
+static const struct BagKernels sse2Kernels =
+	{ "sse2", _findSse2, _countSse2, _removeAllSse2 };
+static const struct BagKernels avx2Kernels =
+	{ "avx2", _findAvx2, _countAvx2, _removeAllAvx2 };
+static const struct BagKernels avx512Kernels =
+	{ "avx512", _findAvx512, _countAvx512, _removeAllAvx512 };
+#endif
+
+/* Chosen on the first call; threads racing there all store the same one */
+static const struct BagKernels *kernels = 0;
+
+/*
+ helper function to get the widest kernels the processor supports
+ */
+const struct BagKernels *_bagKernels(void)
+{
+    const struct BagKernels *k = __atomic_load_n(&kernels, __ATOMIC_RELAXED);
+    if (k != 0) {
+        return k;
+    }
+    k = &scalarKernels;
+#ifdef BAG_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        k = &avx512Kernels;
+    else if (__builtin_cpu_supports("avx2"))
+        k = &avx2Kernels;
+    else if (__builtin_cpu_supports("sse2"))
+        k = &sse2Kernels;
+#endif
+    __atomic_store_n(&kernels, k, __ATOMIC_RELAXED);
+    return k;
+}
+
+int bagScanFind(const int *values, int n, int value)
+{
+    return _bagKernels()->find(values, n, value);
+}
+
+int bagScanCount(const int *values, int n, int value)
+{
+    return _bagKernels()->count(values, n, value);
+}
+
+int bagScanRemoveAll(int *values, int n, int value)
+{
+    return _bagKernels()->removeAll(values, n, value);
+}
+
+const char *bagScanName(void)
+{
+    return _bagKernels()->name;
+}
@@ -0,0 +1,24 @@
+/*
+  File: bagScan.h
+  Vectorized scans of an array of ints for the bag operations of the
+  lists.  Each call compares 4 (SSE2), 8 (AVX2) or 16 (AVX-512) values per
+  instruction; the widest the processor supports is picked on first use,
+  and other processors get a plain loop.  unrolledList.c runs them over
+  each chunk when TYPE is int.
+*/
+
+#ifndef __BAG_SCAN_H
+#define __BAG_SCAN_H
+
+/* Index of the first of values[0 .. n) equal to value, or -1. */
+int bagScanFind(const int *values, int n, int value);
+/* How many of values[0 .. n) are equal to value. */
+int bagScanCount(const int *values, int n, int value);
+/* Removes every value equal to value from values[0 .. n), keeping the
+ * order of the rest at the start, and returns how many are left. */
+int bagScanRemoveAll(int *values, int n, int value);
+
+/* Name of the instruction set in use: "avx512", "avx2", "sse2" or "scalar". */
+const char *bagScanName(void);
+
+# endif
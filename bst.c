@@ -6,24 +6,86 @@
 *
 * Solution description: Implementation of a Binary Search Tree 
 * that can store any arbitrary struct in its nodes.
+* The tree is kept height balanced (AVL) on every add and remove,
+* so its height stays O(log n) whatever order values arrive in.
+* With BST_CONCURRENT one writer and any number of lock-free
+* readers share a tree: the writer never changes a node a reader
+* can see.  It copies the nodes on the path it changes, publishes
+* the new root with one atomic store and retires the old copies
+* through epoch.c.  snapshotBSTree reuses the same path copying:
+* nodes count their parents while snapshots are live, and a
+* node with more than one is copied before it is changed.
 ************************************************************/
 
 #include <stdlib.h>
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <pthread.h>
 #include "bst.h"
 #include "structs.h"
+#include "epoch.h"
+#include "threadPool.h"
+#include "writer.h"
 
 struct Node {
 	TYPE         val;
 	struct Node *left;
 	struct Node *right;
+	int          height;
+	int          size;	/* number of values in this subtree */
+	int          key;	/* key_type(val), only used with BST_INTKEY */
+	unsigned int gen;	/* write that created this copy, BST_CONCURRENT */
+	int          count;	/* values held here, more than 1 only with BST_MULTISET */
+	int          refs;	/* parents pointing here, kept up while snapshots live */
+	TYPE        *dups;	/* the count - 1 values after val, BST_MULTISET */
+};
+
+/* Set on a snapshot of a BST_CONCURRENT tree: the nodes it frees may still
+ * be under readers of the tree, so they go through the epoch. */
+# define BST_RETIRE 0x100
+
+/* Number of nodes carved out of each slab when BST_SLAB is set. */
+# ifndef BST_SLAB_NODES
+# define BST_SLAB_NODES 256
+# endif
+
+/* Values below which bulk loads, set operations and exports are not worth
+ * handing to another thread (see threadPool.h). */
+# ifndef BST_PARALLEL_CUTOFF
+# define BST_PARALLEL_CUTOFF 8192
+# endif
+
+/* A block of nodes owned by one tree.  Slabs are chained together and
+ * released all at once by clearBSTree. */
+struct Slab {
+	struct Slab *next;
+	int          cap;
+	int          used;
+	struct Node  nodes[];
 };
 
 struct BSTree {
 	struct Node *root;
 	int          cnt;
+	int          flags;	/* fixed, readers look at them; BST_SLAB lives in slab */
+	int          slab;	/* BST_SLAB, which a build turns on under readers */
+	struct Slab *slabs;	/* slab chain, only used with BST_SLAB */
+	struct Node *freeList;	/* recycled slab nodes, linked through left */
+	unsigned int gen;	/* current write, BST_CONCURRENT */
+	struct Node **unlinked;	/* nodes the current write replaced, BST_CONCURRENT */
+	int          unlinkedCnt;
+	int          unlinkedCap;
+	struct BSTree *origin;	/* the tree a BST_SNAPSHOT was taken of */
+	int          snapshots;	/* live snapshots of this tree */
+	int          sharing;	/* snapshots were live when the current write began */
+	struct Node **returned;	/* slab nodes snapshots let go of, BST_SLAB */
+	int          returnedCnt;
+	int          returnedCap;
+	int          returnLock;	/* guards returned, snapshots go on any thread */
+#ifdef COLLECT_STATS
+	struct Stats stats;	/* counters, see stats.h */
+#endif
 };
 
 /*----------------------------------------------------------------------------*/
@@ -37,8 +99,41 @@ struct BSTree {
 
 void initBSTree(struct BSTree *tree)
 {
-	tree->cnt  = 0;
-	tree->root = 0;
+	initBSTreeFlags(tree, 0);
+}
+
+/*
+ function to initialize the binary search tree with optional behavior.
+ param: tree
+		flags	a combination of the BST_* flags in bst.h, or 0
+ pre: tree is not null
+ post:	tree size is 0
+		root is null
+		tree->flags = flags
+ */
+
+void initBSTreeFlags(struct BSTree *tree, int flags)
+{
+	tree->cnt      = 0;
+	tree->root     = 0;
+	tree->flags    = flags & ~BST_SLAB;
+	tree->slab     = (flags & BST_SLAB) != 0;
+	tree->slabs    = 0;
+	tree->freeList = 0;
+	tree->gen      = 0;
+	tree->unlinked = 0;
+	tree->unlinkedCnt = 0;
+	tree->unlinkedCap = 0;
+	tree->origin   = 0;
+	tree->snapshots = 0;
+	tree->sharing  = 0;
+	tree->returned = 0;
+	tree->returnedCnt = 0;
+	tree->returnedCap = 0;
+	tree->returnLock = 0;
+#ifdef COLLECT_STATS
+	memset(&tree->stats, 0, sizeof(tree->stats));
+#endif
 }
 
 /*
@@ -59,274 +154,2612 @@ BSTree));
 	return tree;
 }
 
-/*----------------------------------------------------------------------------*/
 /*
-function to free the nodes of a binary search tree
-param: node  the root node of the tree to be freed
+ function to create a binary search tree with optional behavior.
+ param: flags	a combination of the BST_* flags in bst.h, or 0
  pre: none
- post: node and all descendants are deallocated
-*/
+ post: tree->count = 0
+	tree->root = 0;
+	tree->flags = flags
+ */
 
-void _freeBST(struct Node *node)
+struct BSTree*  newBSTreeFlags(int flags)
 {
-	if (node != 0) {
-		_freeBST(node->left);
-		_freeBST(node->right);
-		free(node);
-	}
+	struct BSTree *tree = (struct BSTree *)malloc(sizeof(struct BSTree));
+	assert(tree != 0);
+
+	initBSTreeFlags(tree, flags);
+	return tree;
 }
 
+/*----------------------------------------------------------------------------*/
 /*
- function to clear the nodes of a binary search tree
- param: tree    a binary search tree
- pre: tree is not  null
- post: the nodes of the tree are deallocated
-		root is NULL
-		tree size is 0
-        
+ function to add a slab of nodes to the front of a tree's slab chain
+ param: tree	the binary search tree
+		cap		number of nodes in the slab
+ pre: tree is not null
+		cap > 0
+ post: the new slab is returned and owned by tree
  */
-void clearBSTree(struct BSTree *tree)
+struct Slab *_newSlab(struct BSTree *tree, int cap)
 {
-    if ( tree->root != 0) {
-	_freeBST(tree->root);
-	tree->root = 0;
-    }
-	tree->cnt  = 0;
+    struct Slab *slab = malloc(sizeof(struct Slab) + cap * sizeof(struct Node));
+    assert(slab != 0);
+    slab->cap = cap;
+    slab->used = 0;
+    slab->next = tree->slabs;
+    tree->slabs = slab;
+    return slab;
 }
 
 /*
- function to deallocate a dynamically allocated binary search tree
- param: tree   the binary search tree
+ function to allocate a leaf node holding val
+ param: tree	the binary search tree
+		val		the value to store
+		key		the integer key of val, see _keyOf
  pre: tree is not null
- post: all nodes and the tree structure itself are deallocated.
+ post: the node comes from the tree's free list or slab when BST_SLAB is
+		set, otherwise from malloc
  */
-void deleteBSTree(struct BSTree *tree)
+struct Node *_newNode(struct BSTree *tree, TYPE val, int key)
 {
-	if (tree->root != 0) {
-		clearBSTree(tree);
-	}
-        free(tree);
+    struct Node *new;
+    if (!tree->slab) {
+        new = malloc(sizeof(struct Node));
+        assert(new != 0);
+    }
+    //reuse a node given back by a remove
+    else if (tree->freeList != 0) {
+        new = tree->freeList;
+        tree->freeList = new->left;
+    }
+    //otherwise carve the next node out of the current slab
+    else {
+        struct Slab *slab = tree->slabs;
+        if (slab == 0 || slab->used == slab->cap) {
+            slab = _newSlab(tree, BST_SLAB_NODES);
+        }
+        new = &slab->nodes[slab->used++];
+    }
+    new->val = val;
+    new->key = key;
+    new->left = 0;
+    new->right = 0;
+    new->height = 1;
+    new->size = 1;
+    new->gen = tree->gen;
+    new->count = 1;
+    new->refs = 1;
+    new->dups = 0;
+    STAT_INC(tree->stats.allocated);
+    return new;
 }
 
-/*----------------------------------------------------------------------------*/
 /*
- function to determine if  a binary search tree is empty.
-
- param: tree    the binary search tree
- pre:  tree is not null
+ helper function to get the room kept for n duplicates: a power of two,
+ so the array only grows when n reaches one
  */
-int isEmptyBSTree(struct BSTree *tree) {
-    return (tree->cnt == 0);
+int _dupCap(int n)
+{
+    int cap = 2;
+    while (cap < n) {
+        cap *= 2;
+    }
+    return cap;
 }
 
 /*
- function to determine the size of a binary search tree
-
-param: tree    the binary search tree
-pre:  tree is not null
-*/
-int sizeBSTree(struct BSTree *tree) {
-    return tree->cnt;
+ helper function to copy the duplicates of a node
+ param: cur	the node
+ post: returns a new array with the same count - 1 values, or 0 if none
+ */
+TYPE *_copyDups(struct Node *cur)
+{
+    int n = cur->count - 1;
+    if (n == 0) {
+        return 0;
+    }
+    TYPE *dups = malloc(_dupCap(n) * sizeof(TYPE));
+    assert(dups != 0);
+    memcpy(dups, cur->dups, n * sizeof(TYPE));
+    return dups;
 }
 
-/*----------------------------------------------------------------------------*/
 /*
- recursive helper function to add a node to the binary search tree.
- HINT: You have to use the compare() function to compare values.
- param:  cur	the current root node
- 		val	the value to be added to the binary search tree
- pre:	val is not null
+ helper function to add an equal value to a node, BST_MULTISET
+ param: cur	the node, owned by the current write
+		val	a value that compares equal to cur->val
+ post: cur->count is increased by 1; the caller updates sizes
  */
-struct Node *_addNode(struct Node *cur, TYPE val)
+void _pushDup(struct Node *cur, TYPE val)
 {
-    //val is not null
-    assert(val != NULL);
-    //base case we are at the node we need to create
-    if (cur == 0) {
-        struct Node *new = malloc(sizeof(struct Node));
-        assert(new != 0);
-        new->val = val;
-        new->left = 0;
-        new->right = 0;
-        return new;
+    int n = cur->count - 1;
+    //full when n is 0 or a power of two of at least 2, see _dupCap
+    if (n == 0 || (n >= 2 && (n & (n - 1)) == 0)) {
+        cur->dups = realloc(cur->dups, (n == 0 ? 2 : 2 * n) * sizeof(TYPE));
+        assert(cur->dups != 0);
     }
-    //else if the value we are passing is larger than or equal ci_the current node go to the right
-    else if (compare(val, cur->val) > -1) {
-        cur->right = _addNode(cur->right, val);
+    cur->dups[n] = val;
+    cur->count++;
+}
+
+/*
+ helper function to take one value out of a node holding several
+ param: cur	the node, owned by the current write
+		val	the value to take out: the stored pointer equal to val if
+			there is one, otherwise the last value
+ pre: cur->count > 1
+ post: cur->count is reduced by 1; the caller updates sizes
+ */
+void _dropDup(struct Node *cur, TYPE val)
+{
+    int n = cur->count - 1;
+    int i = n - 1;
+    //the last duplicate fills the hole
+    if (cur->val == val) {
+        cur->val = cur->dups[i];
     }
-    //value param is smaller than current node so go to the left
     else {
-        cur->left = _addNode(cur->left, val);
+        for (int j = 0; j < n; j++) {
+            if (cur->dups[j] == val) {
+                cur->dups[j] = cur->dups[i];
+                break;
+            }
+        }
+    }
+    if (--cur->count == 1) {
+        free(cur->dups);
+        cur->dups = 0;
     }
-    return cur;
 }
 
 /*
- function to add a value to the binary search tree
- param: tree   the binary search tree
-		val		the value to be added to the tree
-
- pre:	tree is not null
-		val is not null
- pose:  tree size increased by 1
-		tree now contains the value, val
+ function to give a node back to the tree's allocator
+ param: tree	the binary search tree
+		node	the node to release
+ pre: node was allocated by _newNode for this tree
+ post: node is pushed on the free list with BST_SLAB, otherwise freed,
+		along with its duplicates
  */
-void addBSTree(struct BSTree *tree, TYPE val)
+void _freeNode(struct BSTree *tree, struct Node *node)
 {
-	tree->root = _addNode(tree->root, val);
-	tree->cnt++;
+    STAT_INC(tree->stats.freed);
+    free(node->dups);
+    node->dups = 0;
+    if (tree->slab) {
+        node->left = tree->freeList;
+        tree->freeList = node;
+    }
+    else {
+        free(node);
+    }
 }
 
+/*
+ epoch callback that hands a retired node back to its tree
+ */
+void _reclaimNode(void *node, void *tree)
+{
+    _freeNode((struct BSTree *)tree, (struct Node *)node);
+}
 
 /*
- function to determine if the binary search tree contains a particular 
-element
- HINT: You have to use the compare() function to compare values.
- param:	tree	the binary search tree
-		val		the value to search for in the tree
- pre:	tree is not null
-		val is not null
- post:	return 1 if found, else return 0 if not found
+ epoch callback that frees a node given up by a snapshot
  */
+void _reclaimShared(void *node, void *ctx)
+{
+    (void)ctx;
+    free(((struct Node *)node)->dups);
+    free(node);
+}
 
-/*----------------------------------------------------------------------------*/
-int containsBSTree(struct BSTree *tree, TYPE val)
+/*
+ function to drop the reference one parent in the tree held on a node
+ param: tree	the binary search tree
+		node	the node, no longer linked from that parent
+ post: without live snapshots the node had no other parent and is freed.
+		With them it is freed only if that was its last parent, and its
+		children then lose it as a parent in turn.  A node readers of a
+		BST_CONCURRENT tree may be on is retired instead; this only
+		happens once the write that unlinked it is published.
+ */
+void _dropRef(struct BSTree *tree, struct Node *node)
 {
-    //tree is not null
-    assert(tree);
-    //val is not null
-    assert(val);
-    //need to start at the root to traverse the tree
-    struct Node *placeholder = tree->root;
-    //search until the whole tree is exhausted or the value is found
-    while (placeholder != 0) {
-        //base case you found the node
-        if (compare(val, placeholder->val) == 0) {
-            return 1;
+    if (tree->sharing) {
+        if (__atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+            return;
         }
-        //case when param value is larger than current node value
-        else if (compare(val,  placeholder->val) == 1) {
-            placeholder = placeholder->right;
+        if (node->left != 0) {
+            _dropRef(tree, node->left);
         }
-        //case when param value is smaller than current node value
-        else {
-            placeholder = placeholder->left;
+        if (node->right != 0) {
+            _dropRef(tree, node->right);
         }
     }
-    //case when value not found
-    return 0;
+    if ((tree->flags & BST_CONCURRENT) && node->gen != tree->gen) {
+        epochRetire(node, _reclaimNode, tree);
+    }
+    else {
+        _freeNode(tree, node);
+    }
 }
 
 /*
- helper function to find the left most child of a node
- return the value of the left most child of cur
- param: cur		the current node
- pre:	cur is not null
- post: none
+ function to add a parent to a node, while snapshots share nodes
+ param: tree	the binary search tree
+		node	the node, may be null
  */
-
-/*----------------------------------------------------------------------------*/
-TYPE _leftMost(struct Node *cur)
+void _addRef(struct BSTree *tree, struct Node *node)
 {
-    //cur is not null
-    assert(cur);
-    //base case there are no more left nodes
-    if (cur->left == 0) {
-        return cur->val;
+    if (tree->sharing && node != 0) {
+        __atomic_add_fetch(&node->refs, 1, __ATOMIC_RELAXED);
     }
-    //otherwise keep going
-    else
-        return _leftMost(cur->left);
 }
 
-
 /*
- recursive helper function to remove the left most child of a node
- HINT: this function returns cur if its left child is NOT NULL. Otherwise,
- it returns the right child of cur and free cur.
+ function to hand a slab node a snapshot let go of back to the tree that
+ allocated it; may run on any thread
+ param: tree	the tree the snapshot was taken of
+		node	the node, no longer linked from either of them
+ post: node waits in tree->returned for the next write of tree, which
+		owns the free list (see _takeReturned)
+ */
+void _returnNode(struct BSTree *tree, struct Node *node)
+{
+    while (__atomic_exchange_n(&tree->returnLock, 1, __ATOMIC_ACQUIRE)) {
+        //held for a few stores, or one realloc
+    }
+    if (tree->returnedCnt == tree->returnedCap) {
+        tree->returnedCap = (tree->returnedCap == 0) ? 64 : 2 * tree->returnedCap;
+        tree->returned = realloc(tree->returned, tree->returnedCap * sizeof(struct Node *));
+        assert(tree->returned != 0);
+    }
+    tree->returned[tree->returnedCnt] = node;
+    //the writer peeks at the count without the lock
+    __atomic_store_n(&tree->returnedCnt, tree->returnedCnt + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&tree->returnLock, 0, __ATOMIC_RELEASE);
+}
 
-Note:  If you do this iteratively, the above hint does not apply.
+/*
+ function to put the slab nodes snapshots gave back on the free list
+ param: tree	the binary search tree, on its writer thread
+ post: the nodes are released like any other the tree unlinked: readers
+		of a BST_CONCURRENT tree may still be on them, so they are retired
+ */
+void _takeReturned(struct BSTree *tree)
+{
+    if (__atomic_load_n(&tree->returnedCnt, __ATOMIC_RELAXED) == 0) {
+        return;
+    }
+    while (__atomic_exchange_n(&tree->returnLock, 1, __ATOMIC_ACQUIRE)) {
+        //a snapshot is handing a node back
+    }
+    for (int i = 0; i < tree->returnedCnt; i++) {
+        if (tree->flags & BST_CONCURRENT) {
+            epochRetire(tree->returned[i], _reclaimNode, tree);
+        }
+        else {
+            _freeNode(tree, tree->returned[i]);
+        }
+    }
+    tree->returnedCnt = 0;
+    __atomic_store_n(&tree->returnLock, 0, __ATOMIC_RELEASE);
+}
 
- param: cur	the current node
- pre:	cur is not null
- post:	the left most node of cur is not in the tree
+/*
+ function to drop a snapshot's reference on a node; may run on any thread
+ param: snap	the snapshot
+		node	the node
+ post: the node and any of its descendants left without a parent are
+		freed, through the epoch for a snapshot of a BST_CONCURRENT tree.
+		Slab nodes go back to the tree they were taken from instead.
  */
-/*----------------------------------------------------------------------------*/
-struct Node *_removeLeftMost(struct Node *cur)
+void _dropShared(struct BSTree *snap, struct Node *node)
 {
-    //cur is not null
-    assert(cur);
-    //if left child is null then return right child of cur and free cur
-    if (cur->left == 0) {
-        struct Node *temp = cur->right;
-        free(cur);
-        return temp;
+    if (__atomic_sub_fetch(&node->refs, 1, __ATOMIC_ACQ_REL) != 0) {
+        return;
+    }
+    if (node->left != 0) {
+        _dropShared(snap, node->left);
+    }
+    if (node->right != 0) {
+        _dropShared(snap, node->right);
+    }
+    //the slab is the tree's, and so is counting the node freed
+    if (snap->slab) {
+        _returnNode(snap->origin, node);
+        return;
+    }
+    STAT_INC(snap->origin->stats.freed);
+    if (snap->flags & BST_RETIRE) {
+        epochRetire(node, _reclaimShared, 0);
     }
-    //otherwise recursive call to set left child to pointer returned by call
-    //and return current node
     else {
-        cur->left = _removeLeftMost(cur->left);
-        return cur;
+        _reclaimShared(node, 0);
     }
 }
+
 /*
- recursive helper function to remove a node from the tree
- HINT: You have to use the compare() function to compare values.
- param:	cur	the current node
-		val	the value to be removed from the tree
- pre:	cur is not null
-		val is not null
+ function to release a node that has been unlinked from the tree
+ param: tree	the binary search tree
+		node	the unlinked node
+ post: with BST_CONCURRENT a node readers may still be on is kept until
+		the write is published (see _endWrite), otherwise it is dropped
+		right away
  */
-/*----------------------------------------------------------------------------*/
-struct Node *_removeNode(struct Node *cur, TYPE val)
+void _releaseNode(struct BSTree *tree, struct Node *node)
 {
-    //cur is not null
-    assert(cur);
-    //val is not null
-    assert(val);
-    //base case: we are at the node we wish to remove
-    if (compare(val, cur->val) == 0) {
-        //we need to check the children of this node
-        //if no right then we can remove current and return left subtree
-        if (cur->right == 0) {
-            struct Node *temp = cur->left;
-            free(cur);
-            return temp;
-        }
-        //otherwise need to replace current with left-most child value of right child
-        //and remove leftMost child of right child
-        else {
-            cur->val = _leftMost(cur->right);
-            cur->right = _removeLeftMost(cur->right);
+    if ((tree->flags & BST_CONCURRENT) && node->gen != tree->gen) {
+        if (tree->unlinkedCnt == tree->unlinkedCap) {
+            tree->unlinkedCap = (tree->unlinkedCap == 0) ? 64 : 2 * tree->unlinkedCap;
+            tree->unlinked = realloc(tree->unlinked, tree->unlinkedCap * sizeof(struct Node *));
+            assert(tree->unlinked != 0);
         }
+        tree->unlinked[tree->unlinkedCnt++] = node;
     }
-    //case when param value is smaller than current node value
-    //continue to the left
-    else if (compare(val, cur->val) == -1) {
-        cur->left = _removeNode(cur->left, val);
+    else {
+        _dropRef(tree, node);
+    }
+}
+
+/*
+ function to unlink a node whose place in its parent goes to one child
+ param: tree	the binary search tree
+		cur		the node, it has no other child
+		child	cur's child, may be null
+ post: returns child
+ */
+struct Node *_unlink(struct BSTree *tree, struct Node *cur, struct Node *child)
+{
+    //child gains its new parent before cur can let go of it
+    _addRef(tree, child);
+    _releaseNode(tree, cur);
+    return child;
+}
+
+/*
+ function to tell if the current write may change a node in place
+ param: tree	the binary search tree
+		cur		a node reached from the root
+ post: returns 1 unless readers of a BST_CONCURRENT tree may see cur or a
+		snapshot shares it
+ */
+int _owned(struct BSTree *tree, struct Node *cur)
+{
+    //nodes created by this write have not been published yet
+    if ((tree->flags & BST_CONCURRENT) && cur->gen != tree->gen) {
+        return 0;
+    }
+    return !tree->sharing || __atomic_load_n(&cur->refs, __ATOMIC_ACQUIRE) == 1;
+}
+
+/*
+ function to get a node the current write may change
+ param: tree	the binary search tree
+		cur		a node reached from the root
+ pre: cur is not null
+ post: returns cur, or a private copy of cur when readers or snapshots may
+		see cur (see _owned); the caller links the copy in its place
+ */
+struct Node *_own(struct BSTree *tree, struct Node *cur)
+{
+    if (_owned(tree, cur)) {
+        return cur;
+    }
+    //field by field, as a snapshot may be dropping its reference on cur
+    struct Node *copy = _newNode(tree, cur->val, cur->key);
+    copy->left = cur->left;
+    copy->right = cur->right;
+    copy->height = cur->height;
+    copy->size = cur->size;
+    copy->count = cur->count;
+    //each node owns its duplicates, and cur keeps its own until freed
+    copy->dups = _copyDups(cur);
+    //the copy is one more parent of cur's children
+    _addRef(tree, copy->left);
+    _addRef(tree, copy->right);
+    _releaseNode(tree, cur);
+    return copy;
+}
+
+/*
+ function to move the values of one node into another, for a remove that
+ replaces a node by its successor
+ param: tree	the binary search tree
+		dst		the node to fill, owned by the current write
+		src		the node about to be unlinked
+ post: dst holds src's values; src keeps its duplicates only when readers
+		or snapshots may still see it
+ */
+void _takeValues(struct BSTree *tree, struct Node *dst, struct Node *src)
+{
+    free(dst->dups);
+    dst->val = src->val;
+    dst->key = src->key;
+    dst->count = src->count;
+    //the path down to src is not copied yet, so with snapshots live one of
+    //them may reach src through a shared ancestor whatever its own count
+    if (!tree->sharing && _owned(tree, src)) {
+        dst->dups = src->dups;
+        src->dups = 0;
     }
-    //case when param value is larger than current node value
-    //continue to the right
     else {
-        cur->right = _removeNode(cur->right, val);
+        dst->dups = _copyDups(src);
     }
-    return cur;
 }
+
 /*
- function to remove a value from the binary search tree
- param: tree   the binary search tree
-		val		the value to be removed from the tree
- pre:	tree is not null
-		val is not null
-		val is in the tree
- pose:	tree size is reduced by 1
+ recursive helper function to mark every node as old
  */
-void removeBSTree(struct BSTree *tree, TYPE val)
+void _resetGen(struct Node *cur)
 {
-	if (containsBSTree(tree, val)) {
-		tree->root = _removeNode(tree->root, val);
-		tree->cnt--;
-	}
+    while (cur != 0) {
+        cur->gen = 0;
+        _resetGen(cur->left);
+        cur = cur->right;
+    }
+}
+
+/*
+ function to start a write: nodes made from now on belong to it
+ param: tree	the binary search tree
+ */
+void _beginWrite(struct BSTree *tree)
+{
+    assert(!(tree->flags & BST_SNAPSHOT));
+    //snapshots only go away during a write, so this cannot turn on midway
+    tree->sharing = __atomic_load_n(&tree->snapshots, __ATOMIC_ACQUIRE) > 0;
+    _takeReturned(tree);
+    if (tree->flags & BST_CONCURRENT) {
+        //after wrapping around an old node could pass for a new one
+        if (++tree->gen == 0) {
+            _resetGen(tree->root);
+            tree->gen = 1;
+        }
+    }
+}
+
+/*
+ function to make a new root visible to readers
+ param: tree	the binary search tree
+		root	the new root, fully built
+ */
+void _setRoot(struct BSTree *tree, struct Node *root)
+{
+    __atomic_store_n(&tree->root, root, __ATOMIC_RELEASE);
+}
+
+/*
+ function to finish a write by publishing its root
+ param: tree	the binary search tree
+		root	the new root, fully built
+ post: the nodes the write replaced are dropped; this has to wait for the
+		new root, as until then new readers can still reach them
+ */
+void _endWrite(struct BSTree *tree, struct Node *root)
+{
+    _setRoot(tree, root);
+    for (int i = 0; i < tree->unlinkedCnt; i++) {
+        _dropRef(tree, tree->unlinked[i]);
+    }
+    tree->unlinkedCnt = 0;
+}
+
+/*
+ function to set the value count seen by sizeBSTree
+ */
+void _setCount(struct BSTree *tree, int cnt)
+{
+    __atomic_store_n(&tree->cnt, cnt, __ATOMIC_RELAXED);
+}
+
+/*
+ function to get the latest root published by _setRoot
+ param: tree	the binary search tree
+ */
+struct Node *_root(struct BSTree *tree)
+{
+    return __atomic_load_n(&tree->root, __ATOMIC_ACQUIRE);
+}
+
+/*
+ function to start a read: enters the epoch with BST_CONCURRENT
+ param: tree	the binary search tree
+ post: returns the root to search from, valid until _endRead
+ */
+struct Node *_beginRead(struct BSTree *tree)
+{
+    if (tree->flags & BST_CONCURRENT) {
+        epochEnter();
+    }
+    return _root(tree);
+}
+
+/*
+ function to end a read started with _beginRead
+ */
+void _endRead(struct BSTree *tree)
+{
+    if (tree->flags & BST_CONCURRENT) {
+        epochExit();
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+function to free the nodes of a binary search tree
+param: node  the root node of the tree to be freed
+ pre: none
+ post: node and all descendants are deallocated
+*/
+
+void _freeBST(struct Node *node)
+{
+	if (node != 0) {
+		_freeBST(node->left);
+		_freeBST(node->right);
+		free(node->dups);
+		free(node);
+	}
+}
+
+/*
+ function to free the nodes of a tree once its root no longer leads to them
+ param: tree    a binary search tree, not a snapshot
+		root	the root readers used to start from
+ pre: a new root has been published
+ post: the nodes under root are deallocated, except the nodes snapshots
+		still hold; so are tree's slabs once no snapshot is left
+ */
+void _releaseTree(struct BSTree *tree, struct Node *root)
+{
+    //readers may still be walking the old nodes, wait until they are done
+    if (tree->flags & BST_CONCURRENT) {
+        epochSynchronize();
+    }
+    tree->sharing = __atomic_load_n(&tree->snapshots, __ATOMIC_ACQUIRE) > 0;
+    //slab nodes go away with their slabs, no need to visit them
+    if (tree->slab && !tree->sharing) {
+        //and so do the ones snapshots gave back, duplicates and all
+        free(tree->returned);
+        tree->returned = 0;
+        tree->returnedCnt = 0;
+        tree->returnedCap = 0;
+        while (tree->slabs != 0) {
+            struct Slab *next = tree->slabs->next;
+            //except for their duplicates; nodes on the free list have none
+            if (tree->flags & BST_MULTISET) {
+                for (int i = 0; i < tree->slabs->used; i++) {
+                    free(tree->slabs->nodes[i].dups);
+                }
+            }
+            free(tree->slabs);
+            tree->slabs = next;
+        }
+        tree->freeList = 0;
+    }
+    //nodes a snapshot holds stay, and their old copies wait for the epoch;
+    //slabs stay too, the free list reuses what is left of them
+    else if (root != 0 && tree->sharing) {
+        _dropRef(tree, root);
+        if (tree->flags & BST_CONCURRENT) {
+            epochSynchronize();
+        }
+    }
+    else if (root != 0) {
+	_freeBST(root);
+    }
+    free(tree->unlinked);
+    tree->unlinked = 0;
+    tree->unlinkedCap = 0;
+#ifdef COLLECT_STATS
+    //every node is gone, including the ones freed with their slabs
+    if (!tree->sharing) {
+        tree->stats.freed = tree->stats.allocated;
+    }
+#endif
+}
+
+/*
+ function to clear the nodes of a binary search tree
+ param: tree    a binary search tree
+ pre: tree is not  null
+ post: the nodes of the tree are deallocated
+		root is NULL
+		tree size is 0
+        
+ */
+void clearBSTree(struct BSTree *tree)
+{
+    struct Node *root = tree->root;
+    _setRoot(tree, 0);
+    _setCount(tree, 0);
+    //a snapshot only lets go of its nodes, the tree may still share them
+    if (tree->flags & BST_SNAPSHOT) {
+        if (tree->origin != 0) {
+            if (root != 0) {
+                _dropShared(tree, root);
+            }
+            __atomic_sub_fetch(&tree->origin->snapshots, 1, __ATOMIC_RELEASE);
+            tree->origin = 0;
+        }
+        return;
+    }
+    _releaseTree(tree, root);
+}
+
+/*
+ function to deallocate a dynamically allocated binary search tree
+ param: tree   the binary search tree
+ pre: tree is not null
+ post: all nodes and the tree structure itself are deallocated.
+ */
+void deleteBSTree(struct BSTree *tree)
+{
+	clearBSTree(tree);
+        free(tree);
+}
+
+/*
+ function to take a read-only snapshot of a binary search tree
+ param: tree	the binary search tree
+ pre: tree is not null and not a BST_SNAPSHOT; with BST_CONCURRENT this
+		is called from the writer thread
+ post: returns a BST_SNAPSHOT tree holding the values tree holds now.  It
+		shares every node with tree, which from now on copies a shared node
+		before changing it, so the snapshot costs O(1) to take and only the
+		nodes later writes replace to keep.  deleteBSTree releases it, from
+		any thread, and tree must outlive it.  Slab nodes it releases go
+		back to tree's free list.
+ */
+struct BSTree *snapshotBSTree(struct BSTree *tree)
+{
+    assert(tree != 0 && !(tree->flags & BST_SNAPSHOT));
+    //a tree turns BST_SLAB on only in a build, which replaces every node,
+    //so the nodes shared now all come from slabs or all from malloc
+    int flags = BST_SNAPSHOT | (tree->flags & (BST_INTKEY | BST_MULTISET));
+    if (tree->slab) {
+        flags |= BST_SLAB;
+    }
+    //nodes it drops may still be under readers of tree
+    if (tree->flags & BST_CONCURRENT) {
+        flags |= BST_RETIRE;
+    }
+    struct BSTree *snap = newBSTreeFlags(flags);
+    snap->origin = tree;
+    //counted first, so the next write of tree sees the root is shared
+    __atomic_add_fetch(&tree->snapshots, 1, __ATOMIC_ACQ_REL);
+    if (tree->root != 0) {
+        __atomic_add_fetch(&tree->root->refs, 1, __ATOMIC_RELAXED);
+    }
+    snap->root = tree->root;
+    snap->cnt = tree->cnt;
+    return snap;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to determine if  a binary search tree is empty.
+
+ param: tree    the binary search tree
+ pre:  tree is not null
+ */
+int isEmptyBSTree(struct BSTree *tree) {
+    return (sizeBSTree(tree) == 0);
+}
+
+/*
+ function to determine the size of a binary search tree
+
+param: tree    the binary search tree
+pre:  tree is not null
+*/
+int sizeBSTree(struct BSTree *tree) {
+    return __atomic_load_n(&tree->cnt, __ATOMIC_RELAXED);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to get the height of a subtree
+ param: cur	the root of the subtree, may be null
+ post:	returns 0 for an empty subtree, 1 for a single node, ...
+ */
+int _height(struct Node *cur)
+{
+    return (cur == 0) ? 0 : cur->height;
+}
+
+/*
+ helper function to get the number of values in a subtree
+ param: cur	the root of the subtree, may be null
+ */
+int _size(struct Node *cur)
+{
+    return (cur == 0) ? 0 : cur->size;
+}
+
+/*
+ helper function to recompute the height and size of a node from its
+ children
+ param: cur	the node to update
+ pre:	cur is not null
+		the heights and sizes of cur's children are correct
+ */
+void _updateNode(struct Node *cur)
+{
+    int left = _height(cur->left);
+    int right = _height(cur->right);
+    cur->height = 1 + (left > right ? left : right);
+    cur->size = cur->count + _size(cur->left) + _size(cur->right);
+}
+
+/*
+ helper function to rotate a subtree to the right
+ param: tree	the tree that owns cur
+		cur	the root of the subtree, owned by the current write
+ pre:	cur and cur->left are not null
+ post:	cur->left is the new root of the subtree and is returned
+ */
+struct Node *_rotateRight(struct BSTree *tree, struct Node *cur)
+{
+    struct Node *pivot = _own(tree, cur->left);
+    //pivot's right subtree becomes cur's left subtree
+    cur->left = pivot->right;
+    pivot->right = cur;
+    //cur is now below pivot so fix its height first
+    _updateNode(cur);
+    _updateNode(pivot);
+    return pivot;
+}
+
+/*
+ helper function to rotate a subtree to the left
+ param: tree	the tree that owns cur
+		cur	the root of the subtree, owned by the current write
+ pre:	cur and cur->right are not null
+ post:	cur->right is the new root of the subtree and is returned
+ */
+struct Node *_rotateLeft(struct BSTree *tree, struct Node *cur)
+{
+    struct Node *pivot = _own(tree, cur->right);
+    //pivot's left subtree becomes cur's right subtree
+    cur->right = pivot->left;
+    pivot->left = cur;
+    //cur is now below pivot so fix its height first
+    _updateNode(cur);
+    _updateNode(pivot);
+    return pivot;
+}
+
+/*
+ helper function to restore the AVL property at a node after one of its
+ subtrees grew or shrank by at most one level
+ param: tree	the tree that owns cur
+		cur	the root of the subtree, owned by the current write
+ pre:	cur is not null
+		both children of cur are balanced
+ post:	the subtree is balanced and its new root is returned
+ */
+struct Node *_balance(struct BSTree *tree, struct Node *cur)
+{
+    _updateNode(cur);
+    int diff = _height(cur->left) - _height(cur->right);
+    //left side is too tall
+    if (diff > 1) {
+        //left-right case needs the left child turned first
+        if (_height(cur->left->left) < _height(cur->left->right)) {
+            cur->left = _rotateLeft(tree, _own(tree, cur->left));
+        }
+        return _rotateRight(tree, cur);
+    }
+    //right side is too tall
+    if (diff < -1) {
+        //right-left case needs the right child turned first
+        if (_height(cur->right->right) < _height(cur->right->left)) {
+            cur->right = _rotateRight(tree, _own(tree, cur->right));
+        }
+        return _rotateLeft(tree, cur);
+    }
+    return cur;
+}
+
+/*
+ helper function to get the integer key of a value
+ param: tree	the binary search tree
+		val		the value
+ post:	returns key_type(val) with BST_INTKEY, otherwise 0
+ */
+int _keyOf(struct BSTree *tree, TYPE val)
+{
+    return (tree->flags & BST_INTKEY) ? key_type(val) : 0;
+}
+
+/*
+ helper function to compare a value against the value in a node
+ param: tree	the binary search tree
+		val		the value
+		key		the integer key of val, see _keyOf
+		cur		the node
+ pre:	cur is not null
+ post:	returns <0, 0 or >0 like compare(val, cur->val)
+ */
+int _compareNode(struct BSTree *tree, TYPE val, int key, struct Node *cur)
+{
+    //integer keys are compared inline without touching the payload
+    STAT_INC(tree->stats.compares);
+    if (tree->flags & BST_INTKEY) {
+        return (key > cur->key) - (key < cur->key);
+    }
+    return compare(val, cur->val);
+}
+
+/*
+ recursive helper function to add a node to the binary search tree.
+ HINT: You have to use the compare() function to compare values.
+ param:  tree	the tree that owns cur
+ 		cur	the current root node
+ 		val	the value to be added to the binary search tree
+ 		key	the integer key of val, see _keyOf
+ pre:	val is not null
+ post:	the subtree is rebalanced and its new root is returned
+ */
+struct Node *_addNode(struct BSTree *tree, struct Node *cur, TYPE val, int key)
+{
+    //val is not null
+    assert(val != NULL);
+    //base case we are at the node we need to create
+    if (cur == 0) {
+        return _newNode(tree, val, key);
+    }
+    //cur gets a new child pointer below, so it must be ours to change
+    cur = _own(tree, cur);
+    int cmp = _compareNode(tree, val, key, cur);
+    //a multiset keeps equal values together in one node
+    if (cmp == 0 && (tree->flags & BST_MULTISET)) {
+        _pushDup(cur, val);
+        _updateNode(cur);
+        return cur;
+    }
+    //if the value we are passing is larger than or equal ci_the current node go to the right
+    if (cmp >= 0) {
+        cur->right = _addNode(tree, cur->right, val, key);
+    }
+    //value param is smaller than current node so go to the left
+    else {
+        cur->left = _addNode(tree, cur->left, val, key);
+    }
+    return _balance(tree, cur);
+}
+
+/*
+ function to add a value to the binary search tree
+ param: tree   the binary search tree
+		val		the value to be added to the tree
+
+ pre:	tree is not null
+		val is not null
+ pose:  tree size increased by 1
+		tree now contains the value, val
+ */
+void addBSTree(struct BSTree *tree, TYPE val)
+{
+	STAT_INC(tree->stats.adds);
+	_beginWrite(tree);
+	_endWrite(tree, _addNode(tree, tree->root, val, _keyOf(tree, val)));
+	_setCount(tree, tree->cnt + 1);
+}
+
+
+/*
+ function to determine if the binary search tree contains a particular 
+element
+ HINT: You have to use the compare() function to compare values.
+ param:	tree	the binary search tree
+		val		the value to search for in the tree
+ pre:	tree is not null
+		val is not null
+ post:	return 1 if found, else return 0 if not found
+ */
+
+/*----------------------------------------------------------------------------*/
+int containsBSTree(struct BSTree *tree, TYPE val)
+{
+    //tree is not null
+    assert(tree);
+    //val is not null
+    assert(val);
+    //need to start at the root to traverse the tree
+    struct Node *placeholder = _beginRead(tree);
+    STAT_INC(tree->stats.lookups);
+    //integer keys get their own loop so the payload is never read
+    if (tree->flags & BST_INTKEY) {
+        int key = key_type(val);
+        while (placeholder != 0 && key != placeholder->key) {
+            STAT_INC(tree->stats.compares);
+            placeholder = (key > placeholder->key) ? placeholder->right : placeholder->left;
+        }
+        _endRead(tree);
+        return placeholder != 0;
+    }
+    //search until the whole tree is exhausted or the value is found
+    while (placeholder != 0) {
+        //compare once per level
+        STAT_INC(tree->stats.compares);
+        int cmp = compare(val, placeholder->val);
+        //base case you found the node
+        if (cmp == 0) {
+            _endRead(tree);
+            return 1;
+        }
+        //case when param value is larger than current node value
+        else if (cmp > 0) {
+            placeholder = placeholder->right;
+        }
+        //case when param value is smaller than current node value
+        else {
+            placeholder = placeholder->left;
+        }
+    }
+    //case when value not found
+    _endRead(tree);
+    return 0;
+}
+
+/*
+ helper function to find the left most child of a node
+ return the left most child of cur
+ param: cur		the current node
+ pre:	cur is not null
+ post: none
+ */
+
+/*----------------------------------------------------------------------------*/
+struct Node *_leftMost(struct Node *cur)
+{
+    //cur is not null
+    assert(cur);
+    //base case there are no more left nodes
+    if (cur->left == 0) {
+        return cur;
+    }
+    //otherwise keep going
+    else
+        return _leftMost(cur->left);
+}
+
+
+/*
+ recursive helper function to remove the left most child of a node
+ HINT: this function returns cur if its left child is NOT NULL. Otherwise,
+ it returns the right child of cur and free cur.
+
+Note:  If you do this iteratively, the above hint does not apply.
+
+ param: tree	the tree that owns cur
+		cur	the current node
+ pre:	cur is not null
+ post:	the left most node of cur is not in the tree
+ */
+/*----------------------------------------------------------------------------*/
+struct Node *_removeLeftMost(struct BSTree *tree, struct Node *cur)
+{
+    //cur is not null
+    assert(cur);
+    //if left child is null then return right child of cur and free cur
+    if (cur->left == 0) {
+        return _unlink(tree, cur, cur->right);
+    }
+    //otherwise recursive call to set left child to pointer returned by call
+    //and return current node, rebalanced
+    else {
+        cur = _own(tree, cur);
+        cur->left = _removeLeftMost(tree, cur->left);
+        return _balance(tree, cur);
+    }
+}
+/*
+ recursive helper function to remove a node from the tree
+ HINT: You have to use the compare() function to compare values.
+ param:	tree	the tree that owns cur
+		cur	the current node
+		val	the value to be removed from the tree
+		key	the integer key of val, see _keyOf
+ pre:	cur is not null
+		val is not null
+ post:	the subtree is rebalanced and its new root is returned
+ */
+/*----------------------------------------------------------------------------*/
+struct Node *_removeNode(struct BSTree *tree, struct Node *cur, TYPE val, int key)
+{
+    //cur is not null
+    assert(cur);
+    //val is not null
+    assert(val);
+    int cmp = _compareNode(tree, val, key, cur);
+    //a node with no right child is unlinked as is, anything else changes cur
+    if (cmp != 0 || cur->right != 0 || cur->count > 1) {
+        cur = _own(tree, cur);
+    }
+    //a multiset node holding more than one value only gives one up
+    if (cmp == 0 && cur->count > 1) {
+        _dropDup(cur, val);
+        _updateNode(cur);
+        return cur;
+    }
+    //base case: we are at the node we wish to remove
+    if (cmp == 0) {
+        //we need to check the children of this node
+        //if no right then we can remove current and return left subtree
+        if (cur->right == 0) {
+            return _unlink(tree, cur, cur->left);
+        }
+        //otherwise need to replace current with left-most child value of right child
+        //and remove leftMost child of right child
+        else {
+            struct Node *next = _leftMost(cur->right);
+            _takeValues(tree, cur, next);
+            cur->right = _removeLeftMost(tree, cur->right);
+        }
+    }
+    //case when param value is smaller than current node value
+    //continue to the left
+    else if (cmp < 0) {
+        cur->left = _removeNode(tree, cur->left, val, key);
+    }
+    //case when param value is larger than current node value
+    //continue to the right
+    else {
+        cur->right = _removeNode(tree, cur->right, val, key);
+    }
+    return _balance(tree, cur);
+}
+/*
+ function to remove a value from the binary search tree
+ param: tree   the binary search tree
+		val		the value to be removed from the tree
+ pre:	tree is not null
+		val is not null
+		val is in the tree
+ pose:	tree size is reduced by 1
+ */
+void removeBSTree(struct BSTree *tree, TYPE val)
+{
+	if (containsBSTree(tree, val)) {
+		STAT_INC(tree->stats.removes);
+		_beginWrite(tree);
+		_endWrite(tree, _removeNode(tree, tree->root, val, _keyOf(tree, val)));
+		_setCount(tree, tree->cnt - 1);
+	}
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to get the pool to split a job over
+ param:	n	number of values the job covers
+ post:	returns the shared pool, or 0 if the job is too small or there is
+		only one core
+ */
+struct ThreadPool *_parallelPool(int n)
+{
+    if (n < BST_PARALLEL_CUTOFF) {
+        return 0;
+    }
+    struct ThreadPool *pool = threadPoolShared();
+    return (threadPoolThreads(pool) > 0) ? pool : 0;
+}
+
+/*
+ function to split sorted values into the groups that share a node: each
+ value on its own, or with BST_MULTISET each run of equal values
+ param:	tree	the binary search tree
+		vals	the sorted values
+		n		number of values
+		groups	receives the number of groups
+ post:	returns 0 when every value is its own group, otherwise an array
+		where group g is vals[runs[g]..runs[g+1]-1]; the caller frees it
+ */
+int *_makeRuns(struct BSTree *tree, TYPE *vals, int n, int *groups)
+{
+    *groups = n;
+    if (!(tree->flags & BST_MULTISET)) {
+        return 0;
+    }
+    int *runs = malloc((n + 1) * sizeof(int));
+    assert(runs != 0);
+    int g = 0;
+    for (int i = 0; i < n; i++) {
+        if (i == 0 || compare(vals[i - 1], vals[i]) != 0) {
+            runs[g++] = i;
+        }
+    }
+    runs[g] = n;
+    *groups = g;
+    return runs;
+}
+
+/*
+ helper function to get the index of the first value of a group
+ */
+int _run(int *runs, int g)
+{
+    return (runs == 0) ? g : runs[g];
+}
+
+/*
+ helper function to fill a node with a group of equal values
+ param:	tree	the tree that owns cur
+		cur		the node, with count 1 and no duplicates
+		vals	the sorted values
+		runs	the groups, see _makeRuns
+		g		the group to store
+ */
+void _fillNode(struct BSTree *tree, struct Node *cur, TYPE *vals, int *runs, int g)
+{
+    int first = _run(runs, g);
+    int end = _run(runs, g + 1);
+    cur->val = vals[first];
+    cur->key = _keyOf(tree, vals[first]);
+    for (int i = first + 1; i < end; i++) {
+        _pushDup(cur, vals[i]);
+    }
+}
+
+/*
+ recursive helper function to build a perfectly balanced subtree from a
+ sorted run of values
+ param:	tree	the tree that owns nodes
+		nodes	block of nodes, one per group
+		vals	the sorted values
+		runs	the groups of vals, see _makeRuns
+		lo		first group of the run
+		hi		one past the last group of the run
+		pool	builds big left halves as pool tasks, or 0
+ pre:	vals is sorted by compare()
+ post:	nodes[lo..hi-1] hold the run in order and the root is returned
+ */
+struct Node *_buildSorted(struct BSTree *tree, struct Node *nodes, TYPE *vals,
+                          int *runs, int lo, int hi, struct ThreadPool *pool);
+
+/* One half of a build, possibly run on another thread. */
+struct BuildTask {
+	struct BSTree     *tree;
+	struct Node       *nodes;
+	TYPE              *vals;
+	int               *runs;
+	int                lo;
+	int                hi;
+	struct ThreadPool *pool;
+	struct Node       *result;
+};
+
+/*
+ pool entry point for the left half of a build
+ */
+void _buildThread(void *arg)
+{
+    struct BuildTask *task = arg;
+    task->result = _buildSorted(task->tree, task->nodes, task->vals, task->runs,
+                                task->lo, task->hi, task->pool);
+}
+
+struct Node *_buildSorted(struct BSTree *tree, struct Node *nodes, TYPE *vals,
+                          int *runs, int lo, int hi, struct ThreadPool *pool)
+{
+    //base case the run is empty
+    if (lo >= hi) {
+        return 0;
+    }
+    //the middle value becomes the root so both halves differ by at most one
+    int mid = lo + (hi - lo) / 2;
+    struct Node *cur = &nodes[mid];
+    //slab memory is not cleared: old to every write, and one parent
+    cur->gen = 0;
+    cur->refs = 1;
+    cur->count = 1;
+    cur->dups = 0;
+    _fillNode(tree, cur, vals, runs, mid);
+    //the halves fill disjoint nodes, so they may be built at the same time
+    if (pool != 0 && mid - lo >= BST_PARALLEL_CUTOFF) {
+        struct BuildTask left = { tree, nodes, vals, runs, lo, mid, pool, 0 };
+        struct PoolTask task;
+        threadPoolSpawn(pool, &task, _buildThread, &left);
+        cur->right = _buildSorted(tree, nodes, vals, runs, mid + 1, hi, pool);
+        threadPoolWait(pool, &task);
+        cur->left = left.result;
+    }
+    else {
+        cur->left = _buildSorted(tree, nodes, vals, runs, lo, mid, pool);
+        cur->right = _buildSorted(tree, nodes, vals, runs, mid + 1, hi, pool);
+    }
+    _updateNode(cur);
+    return cur;
+}
+
+/*
+ function to replace the contents of a tree with a sorted array of values
+ in linear time.  The nodes are allocated in one contiguous slab, so the
+ tree is switched to BST_SLAB if it was not already.  The new tree is
+ published in one step, so readers of a BST_CONCURRENT tree see the old
+ values until then and the new ones after.
+ param:	tree	the binary search tree
+		vals	the values, sorted by compare()
+		n		number of values
+ pre:	tree is not null
+		vals is sorted and holds n non null values
+ post:	tree holds exactly the n values and is perfectly balanced
+ */
+void buildBSTreeFromSorted(struct BSTree *tree, TYPE *vals, int n)
+{
+    assert(tree != 0 && n >= 0 && !(tree->flags & BST_SNAPSHOT));
+    assert(n == 0 || vals != 0);
+    //the new nodes get a slab of their own while the old tree stays up, so
+    //readers of a BST_CONCURRENT tree see one tree or the other, never an
+    //empty one in between
+    struct Slab *oldSlabs = tree->slabs;
+    struct Node *oldFree = tree->freeList;
+    tree->slabs = 0;
+    tree->freeList = 0;
+    struct Node *root = 0;
+    int *runs = 0;
+    int groups = 0;
+    if (n > 0) {
+        runs = _makeRuns(tree, vals, n, &groups);
+        struct Slab *slab = _newSlab(tree, groups);
+        slab->used = groups;
+        root = _buildSorted(tree, slab->nodes, vals, runs, 0, groups, _parallelPool(groups));
+    }
+    struct Slab *fresh = tree->slabs;
+    struct Node *old = tree->root;
+    _setRoot(tree, root);
+    _setCount(tree, n);
+    //the old nodes go under the flags they were made with, then the tree
+    //moves onto slabs
+    tree->slabs = oldSlabs;
+    tree->freeList = oldFree;
+    _releaseTree(tree, old);
+    if (fresh != 0) {
+        fresh->next = tree->slabs;
+        tree->slabs = fresh;
+    }
+    //only the writer looks at slab, readers never see it change
+    tree->slab = 1;
+    STAT_ADD(tree->stats.allocated, groups);
+    free(runs);
+}
+
+/*
+ qsort adapter for compare()
+ */
+int _compareSort(const void *left, const void *right)
+{
+    return compare(*(TYPE *)left, *(TYPE *)right);
+}
+
+/* One part of a parallel sort. */
+struct SortTask {
+	TYPE              *vals;
+	TYPE              *tmp;		/* scratch, as long as vals */
+	int                n;
+	struct ThreadPool *pool;
+};
+
+/*
+ recursive helper function to merge sort values, sorting the left half as
+ a pool task and runs below BST_PARALLEL_CUTOFF with qsort
+ param:	arg	the struct SortTask
+ post:	vals is sorted by compare()
+ */
+void _sortTask(void *arg)
+{
+    struct SortTask *task = arg;
+    int n = task->n;
+    if (n < BST_PARALLEL_CUTOFF) {
+        qsort(task->vals, n, sizeof(TYPE), _compareSort);
+        return;
+    }
+    int half = n / 2;
+    struct SortTask left = { task->vals, task->tmp, half, task->pool };
+    struct SortTask right = { task->vals + half, task->tmp + half, n - half, task->pool };
+    struct PoolTask pending;
+    threadPoolSpawn(task->pool, &pending, _sortTask, &left);
+    _sortTask(&right);
+    threadPoolWait(task->pool, &pending);
+    //merge into the scratch space and copy back, left first on ties
+    TYPE *a = left.vals;
+    TYPE *b = right.vals;
+    TYPE *out = task->tmp;
+    TYPE *aEnd = a + half;
+    TYPE *bEnd = b + (n - half);
+    while (a < aEnd && b < bEnd) {
+        *out++ = (compare(*b, *a) < 0) ? *b++ : *a++;
+    }
+    while (a < aEnd) {
+        *out++ = *a++;
+    }
+    while (b < bEnd) {
+        *out++ = *b++;
+    }
+    memcpy(task->vals, task->tmp, n * sizeof(TYPE));
+}
+
+/*
+ helper function to sort values by compare(), split across cores when
+ there are enough of them
+ param:	vals	the values
+		n		number of values
+ post:	vals is sorted
+ */
+void _sortValues(TYPE *vals, int n)
+{
+    struct ThreadPool *pool = _parallelPool(n);
+    if (pool == 0) {
+        if (n > 1) {
+            qsort(vals, n, sizeof(TYPE), _compareSort);
+        }
+        return;
+    }
+    struct SortTask task = { vals, malloc(n * sizeof(TYPE)), n, pool };
+    assert(task.tmp != 0);
+    _sortTask(&task);
+    free(task.tmp);
+}
+
+/*
+ function to replace the contents of a tree with an unsorted array of
+ values.  vals is sorted in place and then handed to buildBSTreeFromSorted.
+ param:	tree	the binary search tree
+		vals	the values
+		n		number of values
+ pre:	tree is not null
+		vals holds n non null values
+ post:	vals is sorted
+		tree holds exactly the n values and is perfectly balanced
+ */
+void buildBSTree(struct BSTree *tree, TYPE *vals, int n)
+{
+    assert(tree != 0 && n >= 0);
+    _sortValues(vals, n);
+    buildBSTreeFromSorted(tree, vals, n);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to get one of the values held by a node
+ param:	cur	the node
+		j	0 for val, 1.. for the duplicates, below cur->count
+ */
+TYPE _valueAt(struct Node *cur, int j)
+{
+    return (j == 0) ? cur->val : cur->dups[j - 1];
+}
+
+/*
+ recursive helper function to copy a subtree into an array in order
+ param:	cur	the current node
+		out	the array to fill
+		i	the next free slot in out
+ post:	returns the next free slot after the subtree
+ */
+int _toArray(struct Node *cur, TYPE *out, int i)
+{
+    if (cur == 0) {
+        return i;
+    }
+    i = _toArray(cur->left, out, i);
+    for (int j = 0; j < cur->count; j++) {
+        out[i++] = _valueAt(cur, j);
+    }
+    return _toArray(cur->right, out, i);
+}
+
+/*
+ function to copy the values of a tree into an array in sorted order
+ param:	tree	the binary search tree
+		out		array with room for sizeBSTree(tree) values
+ pre:	tree is not null, and no write can change its size meanwhile
+ post:	out holds the values from smallest to largest
+		returns the number of values copied
+ */
+int toArrayBSTree(struct BSTree *tree, TYPE *out)
+{
+    assert(tree != 0);
+    int cnt = _toArray(_beginRead(tree), out, 0);
+    _endRead(tree);
+    return cnt;
+}
+
+/*
+ function to copy the values of a tree into a new array in sorted order
+ param:	tree	the binary search tree
+		cnt		receives the number of values copied
+ pre:	tree and cnt are not null
+ post:	returns a malloc'd array holding the values from smallest to
+		largest, or 0 if out of memory.  The array is sized from the same
+		root the copy walks, so a concurrent write cannot overrun it.
+ */
+TYPE *toNewArrayBSTree(struct BSTree *tree, int *cnt)
+{
+    assert(tree != 0 && cnt != 0);
+    struct Node *root = _beginRead(tree);
+    int n = _size(root);
+    //at least one slot, so 0 only ever means out of memory
+    TYPE *out = malloc((n > 0 ? n : 1) * sizeof(TYPE));
+    *cnt = (out != 0) ? _toArray(root, out, 0) : 0;
+    _endRead(tree);
+    return out;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to count the values that are smaller than val
+ param:	tree		the binary search tree
+		cur			the root to search from
+		val			the value to compare against
+		inclusive	1 to also count values equal to val
+ pre:	tree is not null
+		val is not null
+ */
+int _rank(struct BSTree *tree, struct Node *cur, TYPE val, int inclusive)
+{
+    int key = _keyOf(tree, val);
+    int rank = 0;
+    while (cur != 0) {
+        int cmp = _compareNode(tree, val, key, cur);
+        //cur and its left subtree are counted, the rest is to the right
+        if (cmp > 0 || (cmp == 0 && inclusive)) {
+            rank += _size(cur->left) + cur->count;
+            cur = cur->right;
+        }
+        else {
+            cur = cur->left;
+        }
+    }
+    return rank;
+}
+
+/*
+ function to count the values in the tree that are smaller than val
+ param:	tree	the binary search tree
+		val		the value to compare against
+ pre:	tree is not null
+		val is not null
+ post:	returns the index val would have in sorted order, in O(log n)
+ */
+int rankBSTree(struct BSTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    int rank = _rank(tree, _beginRead(tree), val, 0);
+    _endRead(tree);
+    return rank;
+}
+
+/*
+ function to find the k-th smallest value in the tree
+ param:	tree	the binary search tree
+		k		index of the value in sorted order, starting at 0
+ pre:	tree is not null
+		0 <= k < sizeBSTree(tree)
+ post:	returns the value in O(log n)
+ */
+TYPE selectBSTree(struct BSTree *tree, int k)
+{
+    struct Node *cur = _beginRead(tree);
+    assert(tree != 0 && k >= 0 && k < _size(cur));
+    for (;;) {
+        int left = _size(cur->left);
+        if (k < left) {
+            cur = cur->left;
+        }
+        else if (k < left + cur->count) {
+            TYPE val = _valueAt(cur, k - left);
+            _endRead(tree);
+            return val;
+        }
+        else {
+            k -= left + cur->count;
+            cur = cur->right;
+        }
+    }
+}
+
+/*
+ function to find the smallest value in the tree that is not smaller
+ than val
+ param:	tree	the binary search tree
+		val		the value to compare against
+ pre:	tree is not null
+		val is not null
+ post:	returns that value, or 0 if every value is smaller than val
+ */
+TYPE lowerBoundBSTree(struct BSTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    int key = _keyOf(tree, val);
+    TYPE best = 0;
+    struct Node *cur = _beginRead(tree);
+    while (cur != 0) {
+        //cur is a candidate, anything better is on its left
+        if (_compareNode(tree, val, key, cur) <= 0) {
+            best = cur->val;
+            cur = cur->left;
+        }
+        else {
+            cur = cur->right;
+        }
+    }
+    _endRead(tree);
+    return best;
+}
+
+/*
+ function to count the values in the tree between lo and hi, inclusive
+ param:	tree	the binary search tree
+		lo		the smallest value to count, or 0 for no lower bound
+		hi		the largest value to count, or 0 for no upper bound
+ pre:	tree is not null
+ post:	returns the count in O(log n)
+ */
+int countRangeBSTree(struct BSTree *tree, TYPE lo, TYPE hi)
+{
+    assert(tree != 0);
+    struct Node *root = _beginRead(tree);
+    int below = (lo == 0) ? 0 : _rank(tree, root, lo, 0);
+    int upTo = (hi == 0) ? _size(root) : _rank(tree, root, hi, 1);
+    _endRead(tree);
+    return (upTo > below) ? upTo - below : 0;
+}
+
+/*
+ recursive helper function to visit the values of a subtree between lo
+ and hi in order, skipping subtrees that are out of range
+ param:	tree	the tree that owns cur
+		cur		the current node
+		lo, hi	the bounds, 0 when unbounded
+		loKey, hiKey	the integer keys of lo and hi, see _keyOf
+		fn, arg	the callback and its argument
+ */
+void _forEachInRange(struct BSTree *tree, struct Node *cur, TYPE lo, int loKey,
+                     TYPE hi, int hiKey, void (*fn)(TYPE, void *), void *arg)
+{
+    while (cur != 0) {
+        int aboveLo = (lo == 0) || _compareNode(tree, lo, loKey, cur) <= 0;
+        int belowHi = (hi == 0) || _compareNode(tree, hi, hiKey, cur) >= 0;
+        //values equal to a bound can sit on either side of cur
+        if (aboveLo) {
+            _forEachInRange(tree, cur->left, lo, loKey, hi, hiKey, fn, arg);
+        }
+        if (aboveLo && belowHi) {
+            for (int j = 0; j < cur->count; j++) {
+                fn(_valueAt(cur, j), arg);
+            }
+        }
+        //loop instead of recursing on the right side
+        cur = belowHi ? cur->right : 0;
+    }
+}
+
+/*
+ function to call fn on each value between lo and hi, inclusive, in order
+ param:	tree	the binary search tree
+		lo		the smallest value to visit, or 0 for no lower bound
+		hi		the largest value to visit, or 0 for no upper bound
+		fn		called as fn(val, arg) for each value in range
+		arg		passed through to fn
+ pre:	tree is not null
+		fn does not change the tree
+ post:	runs in O(log n + k) for k visited values
+ */
+void forEachInRangeBSTree(struct BSTree *tree, TYPE lo, TYPE hi,
+                          void (*fn)(TYPE val, void *arg), void *arg)
+{
+    assert(tree != 0 && fn != 0);
+    int loKey = (lo == 0) ? 0 : _keyOf(tree, lo);
+    int hiKey = (hi == 0) ? 0 : _keyOf(tree, hi);
+    _forEachInRange(tree, _beginRead(tree), lo, loKey, hi, hiKey, fn, arg);
+    _endRead(tree);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to push a node and its chain of left children on an
+ iterator's stack
+ param:	it	the iterator
+		cur	the first node to push, may be null
+ */
+void _iterPushLeft(struct BSTreeIter *it, struct Node *cur)
+{
+    while (cur != 0) {
+        //the AVL height bound keeps this inside the fixed stack
+        assert(it->top < BST_ITER_DEPTH);
+        it->stack[it->top++] = cur;
+        cur = cur->left;
+    }
+}
+
+/*
+ function to start an in order walk at the smallest value of the tree
+ param:	tree	the binary search tree
+		it		the iterator, usually a local variable
+ pre:	tree and it are not null
+ post:	the next call to bstIterNext returns the smallest value
+ */
+void bstIterBegin(struct BSTree *tree, struct BSTreeIter *it)
+{
+    assert(tree != 0 && it != 0);
+    it->top = 0;
+    it->dup = 0;
+    _iterPushLeft(it, _root(tree));
+}
+
+/*
+ function to start an in order walk at the first value not smaller than val
+ param:	tree	the binary search tree
+		it		the iterator, usually a local variable
+		val		the value to seek to
+ pre:	tree, it and val are not null
+ post:	the next call to bstIterNext returns lowerBoundBSTree(tree, val)
+ */
+void bstIterSeek(struct BSTree *tree, struct BSTreeIter *it, TYPE val)
+{
+    assert(tree != 0 && it != 0 && val != 0);
+    int key = _keyOf(tree, val);
+    struct Node *cur = _root(tree);
+    it->top = 0;
+    it->dup = 0;
+    //keep only the nodes we pass on their left, they are still to come
+    while (cur != 0) {
+        if (_compareNode(tree, val, key, cur) <= 0) {
+            assert(it->top < BST_ITER_DEPTH);
+            it->stack[it->top++] = cur;
+            cur = cur->left;
+        }
+        else {
+            cur = cur->right;
+        }
+    }
+}
+
+/*
+ function to step an in order walk
+ param:	it		the iterator
+		val		receives the next value
+ pre:	it was started with bstIterBegin or bstIterSeek
+		the tree has not changed since
+ post:	return 1 and set *val, or return 0 when the walk is done
+ */
+int bstIterNext(struct BSTreeIter *it, TYPE *val)
+{
+    assert(it != 0 && val != 0);
+    if (it->top == 0) {
+        return 0;
+    }
+    struct Node *cur = it->stack[it->top - 1];
+    *val = _valueAt(cur, it->dup);
+    //stay on a node until each of its values has been handed out
+    if (++it->dup < cur->count) {
+        return 1;
+    }
+    it->dup = 0;
+    it->top--;
+    //the successor is the left most node of the right subtree, if any
+    _iterPushLeft(it, cur->right);
+    return 1;
+}
+
+/*----------------------------------------------------------------------------*/
+/* Searches advanced together by containsBSTreeBatch.  Enough to cover the
+ * latency of a miss with the compares of the others, small enough that the
+ * cursors stay in registers and L1. */
+# ifndef BST_BATCH_GROUP
+# define BST_BATCH_GROUP 16
+# endif
+
+# if defined(__GNUC__)
+# define PREFETCH(p) __builtin_prefetch(p)
+# else
+# define PREFETCH(p) ((void)0)
+# endif
+
+/*
+ function to check many values at once.  The searches move down the tree
+ one level per round in groups of BST_BATCH_GROUP, and each round only
+ prefetches the nodes the next round will read, so the cache misses of
+ one group overlap instead of being paid one after another.
+ param:	tree	the binary search tree
+		keys	the values to search for
+		n		number of values
+		out		receives 1 or 0 for each value, like containsBSTree
+ pre:	tree is not null
+		keys holds n non null values and out has room for n results
+ post:	out[i] == containsBSTree(tree, keys[i])
+ */
+void containsBSTreeBatch(struct BSTree *tree, TYPE *keys, int n, int *out)
+{
+    assert(tree != 0 && n >= 0);
+    struct Node *root = _beginRead(tree);
+    int payload = !(tree->flags & BST_INTKEY);
+    STAT_ADD(tree->stats.lookups, n);
+    for (int base = 0; base < n; base += BST_BATCH_GROUP) {
+        struct Node *cur[BST_BATCH_GROUP];
+        int key[BST_BATCH_GROUP];
+        int m = (n - base < BST_BATCH_GROUP) ? n - base : BST_BATCH_GROUP;
+        int live = (root != 0) ? m : 0;
+        for (int i = 0; i < m; i++) {
+            assert(keys[base + i] != 0);
+            cur[i] = root;
+            key[i] = _keyOf(tree, keys[base + i]);
+            out[base + i] = 0;
+        }
+        while (live > 0) {
+            //without integer keys the compare reads the payload, which is
+            //one more miss per level; start those before comparing any
+            if (payload) {
+                for (int i = 0; i < m; i++) {
+                    if (cur[i] != 0) {
+                        PREFETCH(cur[i]->val);
+                    }
+                }
+            }
+            live = 0;
+            for (int i = 0; i < m; i++) {
+                struct Node *next = cur[i];
+                if (next == 0) {
+                    continue;
+                }
+                int cmp = _compareNode(tree, keys[base + i], key[i], next);
+                if (cmp == 0) {
+                    out[base + i] = 1;
+                    next = 0;
+                }
+                else {
+                    next = (cmp > 0) ? next->right : next->left;
+                }
+                //the node is read next round, after the rest of the group
+                if (next != 0) {
+                    PREFETCH(next);
+                    live++;
+                }
+                cur[i] = next;
+            }
+        }
+    }
+    _endRead(tree);
+}
+
+/*
+ recursive helper function to build a perfectly balanced subtree of new
+ nodes from a sorted run of values
+ param:	tree	the tree that owns the new nodes
+		vals	the sorted values
+		runs	the groups of vals, see _makeRuns
+		lo		first group of the run
+		hi		one past the last group of the run
+ pre:	vals is sorted by compare()
+ post:	returns the root of the new subtree
+ */
+struct Node *_newSorted(struct BSTree *tree, TYPE *vals, int *runs, int lo, int hi)
+{
+    if (lo >= hi) {
+        return 0;
+    }
+    int mid = lo + (hi - lo) / 2;
+    struct Node *cur = _newNode(tree, 0, 0);
+    _fillNode(tree, cur, vals, runs, mid);
+    cur->left = _newSorted(tree, vals, runs, lo, mid);
+    cur->right = _newSorted(tree, vals, runs, mid + 1, hi);
+    _updateNode(cur);
+    return cur;
+}
+
+/*
+ recursive helper function to join two balanced subtrees with a node that
+ goes between them.  The taller side is walked down its inner spine until
+ the heights match, and _balance repairs each level on the way back up.
+ param:	tree	the tree that owns the nodes
+		left	every value in left sorts before mid
+		mid		the middle node, owned by the current write
+		right	every value in right sorts at or after mid
+ post:	returns the root of the balanced subtree holding all three
+ */
+struct Node *_join(struct BSTree *tree, struct Node *left, struct Node *mid, struct Node *right)
+{
+    int hl = _height(left);
+    int hr = _height(right);
+    if (hl > hr + 1) {
+        left = _own(tree, left);
+        left->right = _join(tree, left->right, mid, right);
+        return _balance(tree, left);
+    }
+    if (hr > hl + 1) {
+        right = _own(tree, right);
+        right->left = _join(tree, left, mid, right->left);
+        return _balance(tree, right);
+    }
+    mid->left = left;
+    mid->right = right;
+    _updateNode(mid);
+    return mid;
+}
+
+/*
+ recursive helper function to add a sorted run of values to a subtree in
+ one descent.  The run is split around cur, each half goes down its own
+ side, and the two results are joined back under cur.  Once a half reaches
+ an empty spot it becomes a balanced subtree of its own.
+ param:	tree	the tree that owns cur
+		cur		the current root node
+		vals	the sorted values
+		runs	the groups of vals, see _makeRuns
+		lo		first group of the run
+		hi		one past the last group of the run
+ pre:	vals is sorted by compare()
+ post:	the subtree is balanced and its new root is returned
+ */
+struct Node *_addSorted(struct BSTree *tree, struct Node *cur, TYPE *vals,
+                        int *runs, int lo, int hi)
+{
+    if (lo >= hi) {
+        return cur;
+    }
+    if (cur == 0) {
+        return _newSorted(tree, vals, runs, lo, hi);
+    }
+    cur = _own(tree, cur);
+    //find the first group that goes right; equal values go right as in _addNode
+    int a = lo, b = hi;
+    while (a < b) {
+        int mid = a + (b - a) / 2;
+        TYPE val = vals[_run(runs, mid)];
+        if (_compareNode(tree, val, _keyOf(tree, val), cur) >= 0) {
+            b = mid;
+        }
+        else {
+            a = mid + 1;
+        }
+    }
+    struct Node *left = _addSorted(tree, cur->left, vals, runs, lo, a);
+    //a multiset takes the group equal to cur into cur itself
+    int next = a;
+    if (runs != 0 && a < hi && _compareNode(tree, vals[runs[a]], _keyOf(tree, vals[runs[a]]), cur) == 0) {
+        for (int i = runs[a]; i < runs[a + 1]; i++) {
+            _pushDup(cur, vals[i]);
+        }
+        next = a + 1;
+    }
+    struct Node *right = _addSorted(tree, cur->right, vals, runs, next, hi);
+    return _join(tree, left, cur, right);
+}
+
+/*
+ function to add many values at once.  vals is sorted in place and then
+ merged into the tree in one descent, so the top of the tree is walked
+ once rather than once per value.
+ param:	tree	the binary search tree
+		vals	the values to be added
+		n		number of values
+ pre:	tree is not null
+		vals holds n non null values
+ post:	vals is sorted
+		tree size increased by n and the tree holds every value in vals
+ */
+void addBSTreeBatch(struct BSTree *tree, TYPE *vals, int n)
+{
+    assert(tree != 0 && n >= 0);
+    if (n == 0) {
+        return;
+    }
+    _sortValues(vals, n);
+    int groups;
+    int *runs = _makeRuns(tree, vals, n, &groups);
+    STAT_ADD(tree->stats.adds, n);
+    _beginWrite(tree);
+    _endWrite(tree, _addSorted(tree, tree->root, vals, runs, 0, groups));
+    _setCount(tree, tree->cnt + n);
+    free(runs);
+}
+
+/*----------------------------------------------------------------------------*/
+/* Set operations.  The inputs are only read: splits and joins make new
+ * nodes from a scratch arena and share untouched subtrees with the inputs,
+ * and the finished result is copied once into a tree of its own. */
+
+# define SET_UNION      0
+# define SET_INTERSECT  1
+# define SET_DIFFERENCE 2
+
+struct SetOp {
+	int              kind;		/* SET_UNION, ... */
+	int              intKey;	/* both inputs cache their keys */
+	int              keepEqual;	/* a has duplicates, see _setRun */
+	struct ThreadPool *pool;	/* splits the work, 0 on one core */
+	pthread_mutex_t  lock;		/* guards slabs */
+	struct Slab     *slabs;		/* scratch nodes of every thread */
+	struct BSTree   *out;		/* the result, set while copying */
+	struct Node     *nodes;		/* out's nodes in sorted order */
+};
+
+/* Where one thread takes its scratch nodes from. */
+struct SetArena {
+	struct SetOp *op;
+	struct Slab  *slab;
+};
+
+/* One half of a subproblem, possibly run on another thread. */
+struct SetTask {
+	struct SetOp *op;
+	struct Node  *a;
+	struct Node  *b;
+	int           lo;		/* index of a's first value in op->nodes */
+	struct Node  *result;
+};
+
+/*
+ helper function to make a scratch node
+ param:	arena	the calling thread's arena
+		left	the new left child
+		from	the node to take the value from
+		right	the new right child
+ post:	returns the node with its height and size set
+ */
+struct Node *_setNode(struct SetArena *arena, struct Node *left,
+                      struct Node *from, struct Node *right)
+{
+    struct Slab *slab = arena->slab;
+    if (slab == 0 || slab->used == slab->cap) {
+        slab = malloc(sizeof(struct Slab) + BST_SLAB_NODES * sizeof(struct Node));
+        assert(slab != 0);
+        slab->cap = BST_SLAB_NODES;
+        slab->used = 0;
+        pthread_mutex_lock(&arena->op->lock);
+        slab->next = arena->op->slabs;
+        arena->op->slabs = slab;
+        pthread_mutex_unlock(&arena->op->lock);
+        arena->slab = slab;
+    }
+    struct Node *cur = &slab->nodes[slab->used++];
+    cur->val = from->val;
+    cur->key = from->key;
+    cur->gen = 0;
+    //the duplicates are shared, only _setCopy gives the result its own
+    cur->count = from->count;
+    cur->dups = from->dups;
+    cur->left = left;
+    cur->right = right;
+    _updateNode(cur);
+    return cur;
+}
+
+/*
+ helper function to compare the values of two nodes
+ post:	returns <0, 0 or >0 like compare(x->val, cur->val)
+ */
+int _setCompare(struct SetOp *op, struct Node *x, struct Node *cur)
+{
+    if (op->intKey) {
+        return (x->key > cur->key) - (x->key < cur->key);
+    }
+    return compare(x->val, cur->val);
+}
+
+/*
+ helper function to make a balanced node out of two subtrees that differ
+ in height by at most two, rotating into new nodes where needed
+ param:	arena	the calling thread's arena
+		left	every value sorts before mid
+		mid		the node to take the middle value from
+		right	every value sorts at or after mid
+ */
+struct Node *_setBalance(struct SetArena *arena, struct Node *left,
+                         struct Node *mid, struct Node *right)
+{
+    int diff = _height(left) - _height(right);
+    if (diff > 1) {
+        //left-right case, the inner grandchild comes up
+        if (_height(left->left) < _height(left->right)) {
+            struct Node *inner = left->right;
+            return _setNode(arena, _setNode(arena, left->left, left, inner->left), inner,
+                            _setNode(arena, inner->right, mid, right));
+        }
+        return _setNode(arena, left->left, left, _setNode(arena, left->right, mid, right));
+    }
+    if (diff < -1) {
+        //right-left case, the inner grandchild comes up
+        if (_height(right->right) < _height(right->left)) {
+            struct Node *inner = right->left;
+            return _setNode(arena, _setNode(arena, left, mid, inner->left), inner,
+                            _setNode(arena, inner->right, right, right->right));
+        }
+        return _setNode(arena, _setNode(arena, left, mid, right->left), right, right->right);
+    }
+    return _setNode(arena, left, mid, right);
+}
+
+/*
+ helper function to join two balanced subtrees with a value between them,
+ like _join but without changing any existing node
+ param:	arena	the calling thread's arena
+		left	every value sorts before mid
+		mid		the node to take the middle value from
+		right	every value sorts at or after mid
+ post:	returns the balanced subtree in O(height difference)
+ */
+struct Node *_setJoin(struct SetArena *arena, struct Node *left,
+                      struct Node *mid, struct Node *right)
+{
+    int hl = _height(left);
+    int hr = _height(right);
+    if (hl > hr + 1) {
+        return _setBalance(arena, left->left, left, _setJoin(arena, left->right, mid, right));
+    }
+    if (hr > hl + 1) {
+        return _setBalance(arena, _setJoin(arena, left, mid, right->left), right, right->right);
+    }
+    return _setNode(arena, left, mid, right);
+}
+
+/*
+ helper function to remove the largest value of a subtree
+ param:	arena	the calling thread's arena
+		cur		the subtree, not null
+		last	receives the node holding the largest value
+ post:	returns the rest of the subtree
+ */
+struct Node *_setSplitLast(struct SetArena *arena, struct Node *cur, struct Node **last)
+{
+    if (cur->right == 0) {
+        *last = cur;
+        return cur->left;
+    }
+    struct Node *rest = _setSplitLast(arena, cur->right, last);
+    return _setJoin(arena, cur->left, cur, rest);
+}
+
+/*
+ helper function to join two balanced subtrees with nothing between them
+ */
+struct Node *_setConcat(struct SetArena *arena, struct Node *left, struct Node *right)
+{
+    if (left == 0) {
+        return right;
+    }
+    if (right == 0) {
+        return left;
+    }
+    struct Node *last;
+    struct Node *rest = _setSplitLast(arena, left, &last);
+    return _setJoin(arena, rest, last, right);
+}
+
+/*
+ helper function to find the smallest or largest value of a subtree
+ param:	cur		the subtree, not null
+		right	1 for the largest value, 0 for the smallest
+ */
+struct Node *_setEdge(struct Node *cur, int right)
+{
+    struct Node *next;
+    while ((next = right ? cur->right : cur->left) != 0) {
+        cur = next;
+    }
+    return cur;
+}
+
+/*
+ helper function to split a subtree around the value of a node
+ param:	arena		the calling thread's arena
+		cur			the subtree to split
+		k			the node holding the value to split at
+		keepEqual	1 to put values equal to k on both sides, 0 to drop them
+		less		receives the values before k, or null if not wanted
+		more		receives the values after k, or null if not wanted
+ post:	returns 1 if the subtree holds a value equal to k, else 0
+ */
+int _setSplit(struct SetArena *arena, struct Node *cur, struct Node *k,
+              int keepEqual, struct Node **less, struct Node **more)
+{
+    struct Node *part;
+    if (cur == 0) {
+        if (less != 0) *less = 0;
+        if (more != 0) *more = 0;
+        return 0;
+    }
+    int cmp = _setCompare(arena->op, k, cur);
+    //cur and its right subtree come after k
+    if (cmp < 0) {
+        int found = _setSplit(arena, cur->left, k, keepEqual, less, more ? &part : 0);
+        if (more != 0) *more = _setJoin(arena, part, cur, cur->right);
+        return found;
+    }
+    //cur and its left subtree come before k
+    if (cmp > 0) {
+        int found = _setSplit(arena, cur->right, k, keepEqual, less ? &part : 0, more);
+        if (less != 0) *less = _setJoin(arena, cur->left, cur, part);
+        return found;
+    }
+    //cur equals k, and more equal values can sit on either side of it
+    if (less != 0) {
+        if (keepEqual) {
+            _setSplit(arena, cur->right, k, keepEqual, &part, 0);
+            *less = _setJoin(arena, cur->left, cur, part);
+        }
+        //usually there are none, which a look at the largest value shows
+        else if (cur->left != 0 && _setCompare(arena->op, _setEdge(cur->left, 1), k) == 0) {
+            _setSplit(arena, cur->left, k, keepEqual, less, 0);
+        }
+        else {
+            *less = cur->left;
+        }
+    }
+    if (more != 0) {
+        if (keepEqual) {
+            _setSplit(arena, cur->left, k, keepEqual, 0, &part);
+            *more = _setJoin(arena, part, cur, cur->right);
+        }
+        else if (cur->right != 0 && _setCompare(arena->op, _setEdge(cur->right, 0), k) == 0) {
+            _setSplit(arena, cur->right, k, keepEqual, 0, more);
+        }
+        else {
+            *more = cur->right;
+        }
+    }
+    return 1;
+}
+
+void _setTask(struct SetArena *arena, struct SetTask *task);
+
+/*
+ pool entry point for a task handed off by _setPair.  The task may run on
+ any thread, so it takes its scratch nodes from an arena of its own.
+ */
+void _setThread(void *arg)
+{
+    struct SetTask *task = arg;
+    struct SetArena arena = { task->op, 0 };
+    _setTask(&arena, task);
+}
+
+/*
+ helper function to run the two halves of a subproblem, the left one as a
+ pool task that an idle thread may steal when it is big enough
+ param:	arena	the calling thread's arena
+		left	the first half
+		right	the second half
+ post:	both tasks have their result
+ */
+void _setPair(struct SetArena *arena, struct SetTask *left, struct SetTask *right)
+{
+    struct SetOp *op = arena->op;
+    if (op->pool != 0 && _size(left->a) + _size(left->b) >= BST_PARALLEL_CUTOFF) {
+        struct PoolTask task;
+        left->op = op;
+        threadPoolSpawn(op->pool, &task, _setThread, left);
+        _setTask(arena, right);
+        threadPoolWait(op->pool, &task);
+        return;
+    }
+    _setTask(arena, left);
+    _setTask(arena, right);
+}
+
+/*
+ recursive helper function to combine two subtrees.  b is split around
+ the root of a, the halves are combined with a's subtrees, and the results
+ are joined back with or without a's root depending on the operation.
+ param:	arena	the calling thread's arena
+		a		subtree of the first input
+		b		subtree of the second input
+ post:	returns the combined subtree, which may share nodes with a and b
+ */
+struct Node *_setRun(struct SetArena *arena, struct Node *a, struct Node *b)
+{
+    int kind = arena->op->kind;
+    if (a == 0) {
+        return (kind == SET_UNION) ? b : 0;
+    }
+    if (b == 0) {
+        return (kind == SET_INTERSECT) ? 0 : a;
+    }
+    struct SetTask left = { 0, a->left, 0, 0, 0 };
+    struct SetTask right = { 0, a->right, 0, 0, 0 };
+    //when a has duplicates of its root on either side, the filtering
+    //operations need b's equal values on both sides too
+    int found = _setSplit(arena, b, a, arena->op->keepEqual, &left.b, &right.b);
+    _setPair(arena, &left, &right);
+    //union always keeps a's root, the others keep it when found says so
+    if (kind == SET_UNION || (kind == SET_INTERSECT) == found) {
+        return _setJoin(arena, left.result, a, right.result);
+    }
+    return _setConcat(arena, left.result, right.result);
+}
+
+/*
+ recursive helper function to copy the combined subtree into the result's
+ nodes, keeping its shape
+ param:	arena	the calling thread's arena
+		cur		the subtree to copy
+		lo		index of its first value in op->nodes
+ post:	returns the copy of cur
+ */
+struct Node *_setCopy(struct SetArena *arena, struct Node *cur, int lo)
+{
+    if (cur == 0) {
+        return 0;
+    }
+    struct SetOp *op = arena->op;
+    int i = lo + _size(cur->left);
+    struct Node *copy = &op->nodes[i];
+    struct SetTask left = { 0, cur->left, 0, lo, 0 };
+    struct SetTask right = { 0, cur->right, 0, i + 1, 0 };
+    _setPair(arena, &left, &right);
+    copy->val = cur->val;
+    copy->key = op->intKey ? cur->key : _keyOf(op->out, cur->val);
+    copy->gen = 0;
+    copy->count = 1;
+    copy->dups = 0;
+    copy->left = left.result;
+    copy->right = right.result;
+    copy->height = cur->height;
+    copy->size = cur->size;
+    return copy;
+}
+
+/*
+ recursive helper function to copy the combined subtree into nodes of the
+ result's own, for BST_MULTISET where sizes count values, not nodes
+ param:	op		the set operation
+		cur		the subtree to copy
+ post:	returns the copy of cur
+ */
+struct Node *_setCopyEach(struct SetOp *op, struct Node *cur)
+{
+    if (cur == 0) {
+        return 0;
+    }
+    struct Node *copy = _newNode(op->out, cur->val, op->intKey ? cur->key : _keyOf(op->out, cur->val));
+    copy->count = cur->count;
+    copy->dups = _copyDups(cur);
+    copy->left = _setCopyEach(op, cur->left);
+    copy->right = _setCopyEach(op, cur->right);
+    copy->height = cur->height;
+    copy->size = cur->size;
+    return copy;
+}
+
+/*
+ helper function to run a task of whichever phase the operation is in
+ */
+void _setTask(struct SetArena *arena, struct SetTask *task)
+{
+    if (arena->op->nodes == 0) {
+        task->result = _setRun(arena, task->a, task->b);
+    }
+    else {
+        task->result = _setCopy(arena, task->a, task->lo);
+    }
+}
+
+/*
+ helper function to check a subtree for values that compare equal
+ param:	op		the set operation
+		cur		the subtree
+ post:	returns 1 if two values of cur compare equal, else 0
+ */
+int _setHasDuplicates(struct SetOp *op, struct Node *cur)
+{
+    struct BSTreeIter it;
+    struct Node *prev = 0;
+    it.top = 0;
+    _iterPushLeft(&it, cur);
+    while (it.top > 0) {
+        cur = it.stack[--it.top];
+        if (prev != 0 && _setCompare(op, prev, cur) == 0) {
+            return 1;
+        }
+        prev = cur;
+        _iterPushLeft(&it, cur->right);
+    }
+    return 0;
+}
+
+/*
+ function to run a set operation
+ param:	a, b	the input trees
+		kind	SET_UNION, SET_INTERSECT or SET_DIFFERENCE
+ pre:	a and b are not null
+ post:	returns a new tree; a and b are unchanged
+ */
+struct BSTree *_setOperation(struct BSTree *a, struct BSTree *b, int kind)
+{
+    assert(a != 0 && b != 0);
+    //a multiset result has one node per key, so both sides must group alike
+    assert(((a->flags ^ b->flags) & BST_MULTISET) == 0);
+    struct SetOp op;
+    op.kind = kind;
+    op.intKey = (a->flags & b->flags & BST_INTKEY) != 0;
+    pthread_mutex_init(&op.lock, 0);
+    op.slabs = 0;
+    op.out = 0;
+    op.nodes = 0;
+    struct SetArena arena = { &op, 0 };
+    //the pool tasks read under these epochs too, as they end before us
+    struct Node *rootA = _beginRead(a);
+    struct Node *rootB = _beginRead(b);
+    op.pool = _parallelPool(_size(rootA) + _size(rootB));
+    //intersect and difference only pay for duplicates in a when there are some
+    op.keepEqual = (kind != SET_UNION) && _setHasDuplicates(&op, rootA);
+    struct Node *result = _setRun(&arena, rootA, rootB);
+
+    //the result still shares nodes with a, b and the scratch arena
+    struct BSTree *out = newBSTreeFlags(BST_SLAB | (a->flags & (BST_INTKEY | BST_MULTISET)));
+    int cnt = _size(result);
+    if (cnt > 0 && (out->flags & BST_MULTISET)) {
+        op.out = out;
+        _setRoot(out, _setCopyEach(&op, result));
+        _setCount(out, cnt);
+    }
+    else if (cnt > 0) {
+        struct Slab *slab = _newSlab(out, cnt);
+        slab->used = cnt;
+        op.out = out;
+        op.nodes = slab->nodes;
+        STAT_ADD(out->stats.allocated, cnt);
+        _setRoot(out, _setCopy(&arena, result, 0));
+        _setCount(out, cnt);
+    }
+    _endRead(b);
+    _endRead(a);
+    while (op.slabs != 0) {
+        struct Slab *next = op.slabs->next;
+        free(op.slabs);
+        op.slabs = next;
+    }
+    pthread_mutex_destroy(&op.lock);
+    return out;
+}
+
+/*
+ function to make a tree with the values of both trees.  Values of b that
+ compare equal to a value of a are left out.
+ param:	a, b	the binary search trees
+ pre:	a and b are not null
+ post:	returns a new balanced tree; a and b are unchanged.  Takes
+		O(m log(n/m + 1)) compares for sizes m <= n, plus the copy of the
+		result, spread over the available cores.
+ */
+struct BSTree *unionBSTree(struct BSTree *a, struct BSTree *b)
+{
+    return _setOperation(a, b, SET_UNION);
+}
+
+/*
+ function to make a tree with the values of a that compare equal to a
+ value of b
+ param:	a, b	the binary search trees
+ pre:	a and b are not null
+ post:	returns a new balanced tree; a and b are unchanged
+ */
+struct BSTree *intersectBSTree(struct BSTree *a, struct BSTree *b)
+{
+    return _setOperation(a, b, SET_INTERSECT);
+}
+
+/*
+ function to make a tree with the values of a that do not compare equal
+ to any value of b
+ param:	a, b	the binary search trees
+ pre:	a and b are not null
+ post:	returns a new balanced tree; a and b are unchanged
+ */
+struct BSTree *differenceBSTree(struct BSTree *a, struct BSTree *b)
+{
+    return _setOperation(a, b, SET_DIFFERENCE);
+}
+
+/*----------------------------------------------------------------------------*/
+/* A piece of a parallel export: a subtree formatted into a buffer of its
+ * own on some thread, or the values of a single node, written in place. */
+struct ExportPart {
+	struct PoolTask  task;
+	struct Node     *root;		/* the subtree, or 0 */
+	struct Node     *node;		/* the node, when root is 0 */
+	int              format;
+	char            *buf;
+	long             len;
+};
+
+/*
+ helper function to write the values of a subtree in order
+ */
+void _exportSubtree(struct Node *cur, struct Writer *w, int format)
+{
+    struct BSTreeIter it;
+    TYPE val;
+    it.top = 0;
+    it.dup = 0;
+    _iterPushLeft(&it, cur);
+    while (bstIterNext(&it, &val)) {
+        export_type(val, w, format);
+    }
+}
+
+/*
+ pool entry point that formats the subtree of a part
+ post:	part->buf holds part->len bytes, freed by the caller
+ */
+void _exportThread(void *arg)
+{
+    struct ExportPart *part = arg;
+    //a guess first; a buffer writer that runs out reports what it needed
+    size_t cap = (size_t)_size(part->root) * 16 + 64;
+    for (;;) {
+        char *buf = malloc(cap);
+        assert(buf != 0);
+        struct Writer w;
+        initWriterBuffer(&w, buf, cap);
+        _exportSubtree(part->root, &w, part->format);
+        long len = finishWriter(&w);
+        if (len >= 0) {
+            part->buf = buf;
+            part->len = len;
+            return;
+        }
+        free(buf);
+        cap = w.total;
+    }
+}
+
+/*
+ recursive helper function to cut a tree into parts of at most
+ BST_PARALLEL_CUTOFF values, in order
+ param:	cur		the subtree
+		parts	filled in from index i, or 0 to only count
+		i		the next part
+		format	passed on to the parts
+ post:	returns the index after the last part of cur
+ */
+int _exportParts(struct Node *cur, struct ExportPart *parts, int i, int format)
+{
+    if (cur == 0) {
+        return i;
+    }
+    if (_size(cur) <= BST_PARALLEL_CUTOFF) {
+        if (parts != 0) {
+            parts[i] = (struct ExportPart){ .root = cur, .format = format };
+        }
+        return i + 1;
+    }
+    i = _exportParts(cur->left, parts, i, format);
+    if (parts != 0) {
+        parts[i] = (struct ExportPart){ .node = cur, .format = format };
+    }
+    return _exportParts(cur->right, parts, i + 1, format);
+}
+
+/*
+ helper function to export a big tree across cores.  The parts are
+ formatted as pool tasks a window ahead of the one being written, so only
+ so many buffers are held at once, and written to w in order.
+ param:	pool	the pool
+		root	the root of the tree, under a read
+		w		the writer
+		format	the format
+ */
+void _exportParallel(struct ThreadPool *pool, struct Node *root, struct Writer *w, int format)
+{
+    int count = _exportParts(root, 0, 0, format);
+    struct ExportPart *parts = malloc(count * sizeof(struct ExportPart));
+    assert(parts != 0);
+    _exportParts(root, parts, 0, format);
+    int window = 4 * (threadPoolThreads(pool) + 1);
+    int spawned = 0;
+    for (int i = 0; i < count; i++) {
+        for (; spawned < count && spawned < i + window; spawned++) {
+            if (parts[spawned].root != 0) {
+                threadPoolSpawn(pool, &parts[spawned].task, _exportThread, &parts[spawned]);
+            }
+        }
+        struct ExportPart *part = &parts[i];
+        if (part->root != 0) {
+            threadPoolWait(pool, &part->task);
+            writeBytes(w, part->buf, part->len);
+            free(part->buf);
+        }
+        else {
+            for (int j = 0; j < part->node->count; j++) {
+                export_type(_valueAt(part->node, j), w, format);
+            }
+        }
+    }
+    free(parts);
+}
+
+/*
+ function to write the values of the tree in order
+ param:	tree	the binary search tree
+		w		the writer, see writer.h
+		format	one of the EXPORT_ formats, passed to export_type
+ pre:	tree and w are not null
+		export_type may be called from several threads at once
+ post:	returns the number of values written
+ */
+int exportBSTree(struct BSTree *tree, struct Writer *w, int format)
+{
+    assert(tree != 0 && w != 0);
+    //the walk is one read, so a concurrent writer cannot free nodes under
+    //it; the pool tasks end before the read does
+    struct Node *root = _beginRead(tree);
+    int cnt = _size(root);
+    struct ThreadPool *pool = _parallelPool(cnt);
+    if (pool != 0) {
+        _exportParallel(pool, root, w, format);
+    }
+    else {
+        _exportSubtree(root, w, format);
+    }
+    _endRead(tree);
+    return cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ recursive helper function to measure a subtree
+ param: cur		the root of the subtree, may be null
+		depth	the depth of cur, the root of the tree is at 0
+		slab	1 if the nodes live in slabs, which are counted apart
+		stats	nodes and bytes are added to
+ post:	returns the sum of the depths of the nodes
+ */
+long _measure(struct Node *cur, int depth, int slab, struct Stats *stats)
+{
+    if (cur == 0) {
+        return 0;
+    }
+    stats->nodes++;
+    if (!slab) {
+        stats->bytes += sizeof(struct Node);
+    }
+    if (cur->count > 1) {
+        stats->bytes += _dupCap(cur->count - 1) * sizeof(TYPE);
+    }
+    return depth + _measure(cur->left, depth + 1, slab, stats)
+                 + _measure(cur->right, depth + 1, slab, stats);
+}
+
+/*
+ function to read the statistics of a binary search tree
+ param:	tree	the binary search tree
+		stats	filled in, see stats.h
+ pre:	tree and stats are not null
+		with BST_CONCURRENT, called from the writer thread
+ post:	the counters are 0 unless built with COLLECT_STATS; the shape is
+		measured with one walk of the tree
+ */
+void getStatsBSTree(struct BSTree *tree, struct Stats *stats)
+{
+    assert(tree != 0 && stats != 0);
+    memset(stats, 0, sizeof(struct Stats));
+#ifdef COLLECT_STATS
+    //readers of a concurrent tree may be counting while we copy
+    stats->adds = __atomic_load_n(&tree->stats.adds, __ATOMIC_RELAXED);
+    stats->removes = __atomic_load_n(&tree->stats.removes, __ATOMIC_RELAXED);
+    stats->lookups = __atomic_load_n(&tree->stats.lookups, __ATOMIC_RELAXED);
+    stats->compares = __atomic_load_n(&tree->stats.compares, __ATOMIC_RELAXED);
+    stats->allocated = __atomic_load_n(&tree->stats.allocated, __ATOMIC_RELAXED);
+    stats->freed = __atomic_load_n(&tree->stats.freed, __ATOMIC_RELAXED);
+#endif
+    stats->bytes = sizeof(struct BSTree);
+    //a slab is held whole, however many of its nodes are in use
+    for (struct Slab *slab = tree->slabs; slab != 0; slab = slab->next) {
+        stats->bytes += sizeof(struct Slab) + slab->cap * sizeof(struct Node);
+    }
+    struct Node *root = _beginRead(tree);
+    stats->size = sizeBSTree(tree);
+    stats->height = _height(root);
+    long depths = _measure(root, 0, tree->slab, stats);
+    _endRead(tree);
+    if (stats->nodes > 0) {
+        stats->avgDepth = (double)depths / stats->nodes;
+    }
 }
 
 /*----------------------------------------------------------------------------*/
@@ -1,6 +1,8 @@
 /*
   File: bst.h
   Interface definition of the binary search tree data structure.
+  Link bst.c with compare.c, epoch.c, threadPool.c, workDeque.c and
+  writer.c, with -pthread (see README.md for every container).
 */
 
 #ifndef __BST_H
@@ -16,20 +18,52 @@
 # define TYPE      void*
 # endif
 
+#include "stats.h"
+
 /* function used to compare two TYPE values to each other, define this in your compare.c file */
 int compare(TYPE left, TYPE right);
 /* function used to print TYPE values, define this in your compare.c file */
 void print_type(TYPE curval);
+/* function used to get an integer key from TYPE values for trees created with
+   BST_INTKEY; it must order values the same way compare() does.  define this
+   in your compare.c file */
+int key_type(TYPE curval);
+/* function used by exportBSTree to write one TYPE value in one of the
+   EXPORT_ formats of writer.h; large trees are exported from several
+   threads at once, so it may only touch w.  define this in your compare.c
+   file */
+struct Writer;
+void export_type(TYPE curval, struct Writer *w, int format);
 
 
 struct BSTree;
 /* Declared in the c source file to hide the structure members from the user. */
 
+/* Optional behavior, combine with | and pass to initBSTreeFlags/newBSTreeFlags. */
+# define BST_SLAB   0x01	/* allocate nodes from per-tree slabs, clear frees whole slabs */
+# define BST_INTKEY 0x02	/* cache key_type() in each node and compare keys inline */
+# define BST_CONCURRENT 0x04	/* one writer, lock-free readers */
+# define BST_MULTISET 0x08	/* values that compare equal share one node */
+# define BST_SNAPSHOT 0x10	/* read-only, made by snapshotBSTree only */
+
+/* With BST_MULTISET a node keeps its first value inline and any equal ones
+   in a small array.  sizeBSTree, the order statistics, toArray and the
+   iterator still see every value; removeBSTree takes out val itself when
+   it is stored, otherwise one of the values equal to it. */
+
 /* Initialize binary search tree structure. */
+/* With BST_CONCURRENT, every reader function (contains, size, the order
+   statistics and toNewArray) may run on any thread at the same time as one
+   writer thread calling add, remove, build or clear; clear and delete wait
+   for the readers to finish.  A build switches from the old values to the
+   new ones in one step. */
+
 void initBSTree(struct BSTree *tree);
+void initBSTreeFlags(struct BSTree *tree, int flags);
 
 /* Alocate and initialize search tree structure. */
 struct BSTree *newBSTree();
+struct BSTree *newBSTreeFlags(int flags);
 
 /* Deallocate nodes in BST. */
 void clearBSTree(struct BSTree *tree);
@@ -37,6 +71,16 @@ void clearBSTree(struct BSTree *tree);
 /* Deallocate nodes in BST and deallocate the BST structure. */
 void deleteBSTree(struct BSTree *tree);
 
+/* O(1) read-only copy of tree as it is now.  tree and the snapshot share
+   their nodes; a write to tree copies the O(log n) nodes it changes that a
+   snapshot still holds, so the memory a snapshot keeps to itself grows with
+   the changes made since it was taken.  Every reader function works on
+   it and may run on another thread while tree is written.  Release it
+   with deleteBSTree before tree goes.
+   The slab nodes it lets go of go back to tree, to be reused by its next
+   write.  With BST_CONCURRENT take it on the writer thread. */
+struct BSTree *snapshotBSTree(struct BSTree *tree);
+
 /*-- BST Bag interface --*/
 int  isEmptyBSTree(struct BSTree *tree);
 int     sizeBSTree(struct BSTree *tree);
@@ -45,4 +89,78 @@ void     addBSTree(struct BSTree *tree, TYPE val);
 int containsBSTree(struct BSTree *tree, TYPE val);
 void  removeBSTree(struct BSTree *tree, TYPE val);
 void  printTree(struct BSTree *tree);
+
+/*-- Bulk loading, both replace the current contents and use BST_SLAB.
+ *   Large inputs are sorted and built on the shared pool of threadPool.h. --*/
+/* vals must already be sorted by compare(); runs in O(n). */
+void buildBSTreeFromSorted(struct BSTree *tree, TYPE *vals, int n);
+/* sorts vals in place first; runs in O(n log n). */
+void buildBSTree(struct BSTree *tree, TYPE *vals, int n);
+
+/* Copies the values into out (sizeBSTree(tree) slots) in sorted order.
+   A write between sizeBSTree and this call changes the size, so with a
+   concurrent writer use toNewArrayBSTree instead. */
+int  toArrayBSTree(struct BSTree *tree, TYPE *out);
+/* Same, into a malloc'd array sized in the same read; *cnt gets the
+   number of values.  Returns 0 if out of memory. */
+TYPE *toNewArrayBSTree(struct BSTree *tree, int *cnt);
+
+/*-- Batched operations --*/
+/* out[i] = containsBSTree(tree, keys[i]); the searches run interleaved so
+ * their cache misses overlap. */
+void containsBSTreeBatch(struct BSTree *tree, TYPE *keys, int n, int *out);
+/* Adds all n values in one descent; sorts vals in place first. */
+void addBSTreeBatch(struct BSTree *tree, TYPE *vals, int n);
+
+/*-- Set operations, each returns a new balanced tree and leaves a and b
+ *   alone.  Values are matched with compare(); the result uses BST_SLAB,
+ *   plus BST_INTKEY and BST_MULTISET if a has them (b must agree on
+ *   BST_MULTISET).  Large inputs are split across cores. --*/
+/* a's values plus b's values that match none of a's. */
+struct BSTree *unionBSTree(struct BSTree *a, struct BSTree *b);
+/* a's values that match one of b's. */
+struct BSTree *intersectBSTree(struct BSTree *a, struct BSTree *b);
+/* a's values that match none of b's. */
+struct BSTree *differenceBSTree(struct BSTree *a, struct BSTree *b);
+
+/*-- Order statistics, all O(log n) plus the values visited --*/
+/* Number of values smaller than val. */
+int  rankBSTree(struct BSTree *tree, TYPE val);
+/* The k-th smallest value, k counts from 0. */
+TYPE selectBSTree(struct BSTree *tree, int k);
+/* Smallest value not smaller than val, or 0 if none. */
+TYPE lowerBoundBSTree(struct BSTree *tree, TYPE val);
+/* Range bounds are inclusive; pass 0 for an open end. */
+int  countRangeBSTree(struct BSTree *tree, TYPE lo, TYPE hi);
+void forEachInRangeBSTree(struct BSTree *tree, TYPE lo, TYPE hi,
+                          void (*fn)(TYPE val, void *arg), void *arg);
+
+/*-- Export --*/
+/* Writes every value in order through export_type and returns how many
+ * there were; see writer.h for the formats and for finishing w.  Large
+ * trees are formatted a subtree per pool task and written in order. */
+int  exportBSTree(struct BSTree *tree, struct Writer *w, int format);
+
+/*-- Statistics --*/
+/* Counters need -DCOLLECT_STATS (see stats.h), the shape is always measured.
+ * With BST_CONCURRENT call it from the writer thread. */
+void getStatsBSTree(struct BSTree *tree, struct Stats *stats);
+
+/*-- In order iterator, no recursion and no allocation --*/
+/* Deep enough for any AVL tree of up to 2^31 values (height <= 45). */
+# define BST_ITER_DEPTH 48
+
+struct BSTreeIter {
+	struct Node *stack[BST_ITER_DEPTH];
+	int          top;
+	int          dup;	/* next value of the top node, BST_MULTISET */
+};
+
+void bstIterBegin(struct BSTree *tree, struct BSTreeIter *it);
+/* Starts at the first value not smaller than val. */
+void bstIterSeek(struct BSTree *tree, struct BSTreeIter *it, TYPE val);
+/* Returns 0 when done, else 1 with the value in *val.  The tree must not
+ * change while an iterator is in use, unless it is a BST_CONCURRENT tree
+ * and the walk is wrapped in epochEnter()/epochExit(). */
+int  bstIterNext(struct BSTreeIter *it, TYPE *val);
 # endif
@@ -0,0 +1,1078 @@
+/* Timing driver for the tree containers.
+ *
+ * build: gcc -O2 -march=native -DNDEBUG -pthread -o bstBench bstBenchMain.c bst.c \
+ *        compare.c epoch.c frozenTree.c btree.c concurrentSet.c mappedTree.c \
+ *        splayTree.c nameIndex.c writer.c threadPool.c workDeque.c
+ * usage: ./bstBench <benchmark> [n]
+ *
+ * Most benchmarks only time; "linearize" checks the ConcurrentSet results
+ * and exits with 1 if any of them is wrong.
+ */
+#include "bst.h"
+#include "structs.h"
+#include "frozenTree.h"
+#include "btree.h"
+#include "epoch.h"
+#include "concurrentSet.h"
+#include "mappedTree.h"
+#include "splayTree.h"
+#include "nameIndex.h"
+#include "writer.h"
+#include "bstTemplate.h"
+#include "dequeTemplate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sched.h>
+#include <fcntl.h>
+
+#define LOOKUPS 4000000
+
+/* set by a benchmark that checks its results and found a wrong one */
+static int failures;
+
+/* typed instances of the template containers for benchTemplate */
+#define DATA_COMPARE(A, B) TEMPLATE_COMPARE((A)->number, (B)->number)
+DEFINE_BSTREE(IntTree, int, TEMPLATE_COMPARE)
+DEFINE_BSTREE(DataTree, struct data *, DATA_COMPARE)
+DEFINE_DEQUE(DataDeque, struct data *)
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long long rngState = 88172645463325252ULL;
+
+static unsigned long long rng(void)
+{
+	rngState ^= rngState << 13;
+	rngState ^= rngState >> 7;
+	rngState ^= rngState << 17;
+	return rngState;
+}
+
+/* n records with distinct even numbers, in random order */
+static struct data *makeData(int n)
+{
+	struct data *d = malloc(n * sizeof(struct data));
+	for (int i = 0; i < n; i++) {
+		d[i].number = 2 * i;
+		d[i].name = 0;
+	}
+	for (int i = n - 1; i > 0; i--) {
+		int j = rng() % (i + 1);
+		struct data tmp = d[i];
+		d[i] = d[j];
+		d[j] = tmp;
+	}
+	return d;
+}
+
+/* lookup keys, about half of them present */
+static struct data *makeQueries(int n, int count)
+{
+	struct data *q = malloc(count * sizeof(struct data));
+	for (int i = 0; i < count; i++) {
+		q[i].number = rng() % (2 * (unsigned long long)n);
+		q[i].name = 0;
+	}
+	return q;
+}
+
+static void report(const char *what, int n, int ops, double secs, long found)
+{
+	printf("%-24s n=%-10d %8.1f ns/op %10.2f Mops/s  (found %ld)\n",
+	       what, n, secs * 1e9 / ops, ops / secs / 1e6, found);
+}
+
+/* pointer tree vs frozen Eytzinger snapshot */
+static void benchFrozen(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	struct BSTree *tree = newBSTree();
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+
+	double t = now();
+	long found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += containsBSTree(tree, &q[i]);
+	report("containsBSTree", n, LOOKUPS, now() - t, found);
+
+	t = now();
+	struct FrozenTree *frozen = freezeBSTree(tree);
+	printf("%-24s n=%-10d %8.3f s\n", "freezeBSTree", n, now() - t);
+
+	t = now();
+	found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += containsFrozenTree(frozen, &q[i]);
+	report("containsFrozenTree", n, LOOKUPS, now() - t, found);
+
+	deleteFrozenTree(frozen);
+	deleteBSTree(tree);
+	free(q);
+	free(d);
+}
+
+/* binary tree vs cache line wide B-tree */
+static void benchBTree(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	struct BSTree *tree = newBSTree();
+	struct BTree *btree = newBTree();
+
+	double t = now();
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+	report("addBSTree", n, n, now() - t, n);
+	t = now();
+	for (int i = 0; i < n; i++)
+		addBTree(btree, &d[i]);
+	report("addBTree", n, n, now() - t, n);
+
+	t = now();
+	long found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += containsBSTree(tree, &q[i]);
+	report("containsBSTree", n, LOOKUPS, now() - t, found);
+	t = now();
+	found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += containsBTree(btree, &q[i]);
+	report("containsBTree", n, LOOKUPS, now() - t, found);
+
+	t = now();
+	for (int i = 0; i < n; i += 2)
+		removeBSTree(tree, &d[i]);
+	report("removeBSTree", n, n / 2, now() - t, n / 2);
+	t = now();
+	for (int i = 0; i < n; i += 2)
+		removeBTree(btree, &d[i]);
+	report("removeBTree", n, n / 2, now() - t, n / 2);
+
+	deleteBTree(btree);
+	deleteBSTree(tree);
+	free(q);
+	free(d);
+}
+
+/* compare() on the payload vs integer keys cached in the nodes */
+static void benchIntKey(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	int modes[] = { 0, BST_INTKEY };
+	const char *names[] = { "containsBSTree", "containsBSTree INTKEY" };
+
+	for (int m = 0; m < 2; m++) {
+		struct BSTree *tree = newBSTreeFlags(modes[m]);
+		for (int i = 0; i < n; i++)
+			addBSTree(tree, &d[i]);
+		double t = now();
+		long found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsBSTree(tree, &q[i]);
+		report(names[m], n, LOOKUPS, now() - t, found);
+		deleteBSTree(tree);
+	}
+	free(q);
+	free(d);
+}
+
+/* one writer plus a growing number of readers, mutex vs BST_CONCURRENT */
+#define RUN_SECONDS 0.5
+
+struct readerArgs {
+	struct BSTree   *tree;
+	pthread_mutex_t *lock;	/* 0 for lock-free reads */
+	struct data     *q;
+	atomic_int      *stop;
+	long             ops;
+};
+
+static void *readerThread(void *arg)
+{
+	struct readerArgs *ra = arg;
+	long ops = 0;
+	while (!*ra->stop) {
+		for (int i = 0; i < 1024; i++) {
+			struct data *key = &ra->q[(ops + i) % LOOKUPS];
+			if (ra->lock)
+				pthread_mutex_lock(ra->lock);
+			containsBSTree(ra->tree, key);
+			if (ra->lock)
+				pthread_mutex_unlock(ra->lock);
+		}
+		ops += 1024;
+	}
+	ra->ops = ops;
+	epochThreadExit();
+	return 0;
+}
+
+static void benchReaders(int n)
+{
+	struct data *d = makeData(n);
+	struct data *extra = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char *names[] = { "mutex", "BST_CONCURRENT" };
+
+	for (int i = 0; i < n; i++)
+		extra[i].number++;	/* odd numbers, never looked up */
+	for (int m = 0; m < 2; m++) {
+		for (int threads = 1; threads <= 2 * cpus; threads *= 2) {
+			struct BSTree *tree = newBSTreeFlags(BST_INTKEY | (m ? BST_CONCURRENT : 0));
+			pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+			atomic_int stop = 0;
+			struct readerArgs args[threads];
+			pthread_t ids[threads];
+			for (int i = 0; i < n; i++)
+				addBSTree(tree, &d[i]);
+			for (int i = 0; i < threads; i++) {
+				args[i] = (struct readerArgs){ tree, m ? 0 : &lock, q, &stop, 0 };
+				pthread_create(&ids[i], 0, readerThread, &args[i]);
+			}
+			/* the writer keeps adding and removing keys nobody looks for */
+			double t = now();
+			long writes = 0;
+			while (now() - t < RUN_SECONDS) {
+				struct data *v = &extra[writes % n];
+				if (!m)
+					pthread_mutex_lock(&lock);
+				if ((writes / n) % 2 == 0)
+					addBSTree(tree, v);
+				else
+					removeBSTree(tree, v);
+				if (!m)
+					pthread_mutex_unlock(&lock);
+				writes++;
+			}
+			stop = 1;
+			long reads = 0;
+			for (int i = 0; i < threads; i++) {
+				pthread_join(ids[i], 0);
+				reads += args[i].ops;
+			}
+			double secs = now() - t;
+			printf("%-16s readers=%-3d n=%-10d %8.2f Mreads/s %8.2f Mwrites/s\n",
+			       names[m], threads, n, reads / secs / 1e6, writes / secs / 1e6);
+			deleteBSTree(tree);
+		}
+	}
+	epochThreadExit();
+	free(q);
+	free(extra);
+	free(d);
+}
+
+/* every thread adds, removes and searches: mutex + BSTree vs ConcurrentSet */
+struct writerArgs {
+	struct BSTree        *tree;
+	pthread_mutex_t      *lock;
+	struct ConcurrentSet *set;	/* 0 for the mutex run */
+	struct data          *keys;
+	int                   n;
+	atomic_int           *stop;
+	long                  ops;
+	unsigned long long    seed;
+};
+
+static void *writerThread(void *arg)
+{
+	struct writerArgs *wa = arg;
+	unsigned long long r = wa->seed;
+	long ops = 0;
+	while (!*wa->stop) {
+		for (int i = 0; i < 256; i++) {
+			r ^= r << 13;
+			r ^= r >> 7;
+			r ^= r << 17;
+			struct data *key = &wa->keys[r % (2 * (unsigned long long)wa->n)];
+			int op = (r >> 40) % 4;	/* half searches, a quarter each add/remove */
+			if (wa->set) {
+				if (op == 0)
+					addConcurrentSet(wa->set, key);
+				else if (op == 1)
+					removeConcurrentSet(wa->set, key);
+				else
+					containsConcurrentSet(wa->set, key);
+				continue;
+			}
+			pthread_mutex_lock(wa->lock);
+			if (op == 0) {
+				if (!containsBSTree(wa->tree, key))
+					addBSTree(wa->tree, key);
+			}
+			else if (op == 1)
+				removeBSTree(wa->tree, key);
+			else
+				containsBSTree(wa->tree, key);
+			pthread_mutex_unlock(wa->lock);
+		}
+		ops += 256;
+	}
+	wa->ops = ops;
+	epochThreadExit();
+	return 0;
+}
+
+static void benchWriters(int n)
+{
+	struct data *keys = malloc(2 * (size_t)n * sizeof(struct data));
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	const char *names[] = { "mutex BSTree", "ConcurrentSet" };
+
+	for (int i = 0; i < 2 * n; i++) {
+		keys[i].number = i;
+		keys[i].name = 0;
+	}
+	for (int m = 0; m < 2; m++) {
+		for (int threads = 1; threads <= 2 * cpus; threads *= 2) {
+			struct BSTree *tree = newBSTreeFlags(BST_INTKEY);
+			struct ConcurrentSet *set = newConcurrentSet();
+			pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+			atomic_int stop = 0;
+			struct writerArgs args[threads];
+			pthread_t ids[threads];
+			for (int i = 0; i < 2 * n; i += 2) {
+				addBSTree(tree, &keys[i]);
+				addConcurrentSet(set, &keys[i]);
+			}
+			double t = now();
+			for (int i = 0; i < threads; i++) {
+				args[i] = (struct writerArgs){ tree, &lock, m ? set : 0, keys, n,
+				                               &stop, 0, rng() | 1 };
+				pthread_create(&ids[i], 0, writerThread, &args[i]);
+			}
+			while (now() - t < RUN_SECONDS)
+				sched_yield();
+			stop = 1;
+			long ops = 0;
+			for (int i = 0; i < threads; i++) {
+				pthread_join(ids[i], 0);
+				ops += args[i].ops;
+			}
+			double secs = now() - t;
+			printf("%-16s threads=%-3d n=%-10d %8.2f Mops/s  (size %d)\n", names[m],
+			       threads, n, ops / secs / 1e6,
+			       m ? sizeConcurrentSet(set) : sizeBSTree(tree));
+			deleteConcurrentSet(set);
+			deleteBSTree(tree);
+		}
+	}
+	epochThreadExit();
+	free(keys);
+}
+
+/* Checks that concurrent ConcurrentSet operations agree with some order of
+ * them one at a time.  The 4n keys fall in four ranges, whose results are
+ * checked differently:
+ *   [0, n)    shared by all threads, even keys present at first: per key,
+ *             the adds minus the removes that reported a change, plus the
+ *             start, must be 0 or 1 and match a contains at the end
+ *   [n, 2n)   present throughout: contains is 1, add 0 and never removed
+ *   [2n, 3n)  absent throughout: contains and remove are 0, never added
+ *   [3n, 4n)  a slice per thread: every result matches a plain set the
+ *             thread keeps alongside
+ * and sizeConcurrentSet at the end must match the count of present keys. */
+struct linearArgs {
+	struct ConcurrentSet *set;
+	struct data          *keys;
+	int                   n;
+	int                   ops;
+	unsigned long long    seed;
+	int                  *added;	/* per shared key, adds that returned 1 */
+	int                  *removed;	/* per shared key, removes that returned 1 */
+	int                   lo, hi;	/* the thread's own keys */
+	char                 *own;	/* own[k - lo], 1 if key k is in the set */
+	long                  wrong;
+};
+
+static void *linearThread(void *arg)
+{
+	struct linearArgs *la = arg;
+	unsigned long long r = la->seed;
+	int n = la->n;
+	for (int i = 0; i < la->ops; i++) {
+		r ^= r << 13;
+		r ^= r >> 7;
+		r ^= r << 17;
+		int range = (r >> 32) % 20;	/* half shared, a fifth own, the rest stable */
+		int op = (r >> 40) % 3;
+		int k;
+		if (range < 10)
+			k = r % n;
+		else if (range < 14)
+			k = la->lo + r % (la->hi - la->lo);
+		else if (range < 17)
+			k = n + r % n;
+		else
+			k = 2 * n + r % n;
+		/* the stable keys are only ever added when present and removed
+		 * when absent, so a right answer never changes them */
+		if ((k >= n && k < 2 * n && op == 1) || (k >= 2 * n && k < 3 * n && op == 0))
+			op = 1 - op;
+		struct data *key = &la->keys[k];
+		int got = (op == 0) ? addConcurrentSet(la->set, key)
+		        : (op == 1) ? removeConcurrentSet(la->set, key)
+		        : containsConcurrentSet(la->set, key);
+		if (k < n) {
+			/* a shared key only has its changes counted */
+			if (op == 0)
+				la->added[k] += got;
+			else if (op == 1)
+				la->removed[k] += got;
+		} else if (k < 2 * n) {
+			la->wrong += (op == 2) ? got != 1 : got != 0;
+		} else if (k < 3 * n) {
+			la->wrong += got != 0;
+		} else {
+			char *in = &la->own[k - la->lo];
+			int expect = (op == 0) ? !*in : *in;
+			la->wrong += got != expect;
+			if (op == 0)
+				*in = 1;
+			else if (op == 1)
+				*in = 0;
+		}
+	}
+	epochThreadExit();
+	return 0;
+}
+
+static void benchLinearize(int n)
+{
+	struct data *keys = malloc(4 * (size_t)n * sizeof(struct data));
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+	for (int i = 0; i < 4 * n; i++) {
+		keys[i].number = i;
+		keys[i].name = 0;
+	}
+	/* at least two threads, as one would only ever see its own order */
+	for (int threads = 2; threads <= 2 * cpus || threads == 2; threads *= 2) {
+		struct ConcurrentSet *set = newConcurrentSet();
+		struct linearArgs args[threads];
+		pthread_t ids[threads];
+		for (int i = 0; i < n; i += 2)
+			addConcurrentSet(set, &keys[i]);
+		for (int i = n; i < 2 * n; i++)
+			addConcurrentSet(set, &keys[i]);
+		for (int i = 0; i < threads; i++) {
+			int lo = 3 * n + (int)((long)n * i / threads);
+			int hi = 3 * n + (int)((long)n * (i + 1) / threads);
+			args[i] = (struct linearArgs){ set, keys, n, 2 * n, 0x9e3779b97f4a7c15ULL * (i + 1),
+			                               calloc(n, sizeof(int)), calloc(n, sizeof(int)),
+			                               lo, hi, calloc(hi - lo, 1), 0 };
+		}
+		double t = now();
+		for (int i = 0; i < threads; i++)
+			pthread_create(&ids[i], 0, linearThread, &args[i]);
+		for (int i = 0; i < threads; i++)
+			pthread_join(ids[i], 0);
+		double secs = now() - t;
+
+		/* replay the counts one key at a time */
+		long wrong = 0, badNet = 0, badContains = 0;
+		int present = n;
+		for (int i = 0; i < threads; i++) {
+			wrong += args[i].wrong;
+			for (int k = 0; k < args[i].hi - args[i].lo; k++) {
+				int in = containsConcurrentSet(set, &keys[args[i].lo + k]);
+				badContains += in != args[i].own[k];
+				present += in;
+			}
+		}
+		for (int k = 0; k < n; k++) {
+			int net = (k % 2 == 0);
+			for (int i = 0; i < threads; i++)
+				net += args[i].added[k] - args[i].removed[k];
+			int in = containsConcurrentSet(set, &keys[k]);
+			badNet += net != 0 && net != 1;
+			badContains += in != net;
+			present += in;
+		}
+		for (int k = n; k < 3 * n; k++)
+			badContains += containsConcurrentSet(set, &keys[k]) != (k < 2 * n);
+		int size = sizeConcurrentSet(set);
+		int ok = wrong == 0 && badNet == 0 && badContains == 0 && size == present;
+		printf("linearize threads=%-3d n=%-10d %8.1f ns/op  %s", threads, n,
+		       secs * 1e9 / (2.0 * n) / threads, ok ? "ok\n" : "MISMATCH");
+		if (!ok)
+			printf(": %ld wrong results, %ld keys with a net count other than "
+			       "0 or 1, %ld wrong at the end, size %d for %d keys\n",
+			       wrong, badNet, badContains, size, present);
+		failures += !ok;
+		for (int i = 0; i < threads; i++) {
+			free(args[i].added);
+			free(args[i].removed);
+			free(args[i].own);
+		}
+		deleteConcurrentSet(set);
+	}
+	epochThreadExit();
+	free(keys);
+}
+
+/* one lookup at a time vs interleaved batches, and per value vs batched adds */
+#define BATCH 256
+
+static void benchBatch(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	TYPE *keys = malloc(LOOKUPS * sizeof(TYPE));
+	int *out = malloc(BATCH * sizeof(int));
+	int modes[] = { 0, BST_INTKEY };
+	const char *single[] = { "containsBSTree", "containsBSTree INTKEY" };
+	const char *batch[] = { "containsBSTreeBatch", "containsBSTreeBatch INTKEY" };
+
+	for (int i = 0; i < LOOKUPS; i++)
+		keys[i] = &q[i];
+	for (int m = 0; m < 2; m++) {
+		struct BSTree *tree = newBSTreeFlags(modes[m]);
+		for (int i = 0; i < n; i++)
+			addBSTree(tree, &d[i]);
+		double t = now();
+		long found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsBSTree(tree, keys[i]);
+		report(single[m], n, LOOKUPS, now() - t, found);
+		t = now();
+		found = 0;
+		for (int i = 0; i + BATCH <= LOOKUPS; i += BATCH) {
+			containsBSTreeBatch(tree, keys + i, BATCH, out);
+			for (int j = 0; j < BATCH; j++)
+				found += out[j];
+		}
+		report(batch[m], n, LOOKUPS / BATCH * BATCH, now() - t, found);
+		deleteBSTree(tree);
+	}
+
+	/* grow a tree from empty in request sized chunks */
+	struct BSTree *tree = newBSTreeFlags(BST_INTKEY);
+	double t = now();
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+	report("addBSTree INTKEY", n, n, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+	tree = newBSTreeFlags(BST_INTKEY);
+	TYPE *vals = malloc(n * sizeof(TYPE));
+	for (int i = 0; i < n; i++)
+		vals[i] = &d[i];
+	t = now();
+	for (int i = 0; i < n; i += BATCH)
+		addBSTreeBatch(tree, vals + i, (n - i < BATCH) ? n - i : BATCH);
+	report("addBSTreeBatch INTKEY", n, n, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+	free(vals);
+
+	free(out);
+	free(keys);
+	free(q);
+	free(d);
+}
+
+/* rebuilding from records with addBSTree vs mapping a saved file */
+static void benchMapped(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	const char *path = "bstBench.map";
+	char buf[32];
+
+	for (int i = 0; i < n; i++) {
+		snprintf(buf, sizeof(buf), "name%d", d[i].number);
+		d[i].name = strdup(buf);
+	}
+	struct BSTree *tree = newBSTreeFlags(BST_INTKEY);
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+	double t = now();
+	if (saveBSTree(tree, path) != 0) {
+		perror(path);
+		exit(1);
+	}
+	printf("%-24s n=%-10d %8.3f s\n", "saveBSTree", n, now() - t);
+	deleteBSTree(tree);
+
+	/* what a restart does today: copy every record and name, then add it */
+	t = now();
+	struct data *copy = malloc(n * sizeof(struct data));
+	tree = newBSTreeFlags(BST_INTKEY);
+	for (int i = 0; i < n; i++) {
+		copy[i].number = d[i].number;
+		copy[i].name = strdup(d[i].name);
+		addBSTree(tree, &copy[i]);
+	}
+	printf("%-24s n=%-10d %8.3f s\n", "rebuild with addBSTree", n, now() - t);
+
+	t = now();
+	struct MappedTree *mapped = mapBSTree(path);
+	if (mapped == 0) {
+		perror(path);
+		exit(1);
+	}
+	printf("%-24s n=%-10d %8.3f s\n", "mapBSTree", n, now() - t);
+
+	t = now();
+	long found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += containsBSTree(tree, &q[i]);
+	report("containsBSTree INTKEY", n, LOOKUPS, now() - t, found);
+	t = now();
+	found = 0;
+	struct data rec;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += findMappedTree(mapped, &q[i], &rec);
+	report("findMappedTree", n, LOOKUPS, now() - t, found);
+
+	unmapBSTree(mapped);
+	remove(path);
+	deleteBSTree(tree);
+	for (int i = 0; i < n; i++) {
+		free(copy[i].name);
+		free(d[i].name);
+	}
+	free(copy);
+	free(q);
+	free(d);
+}
+
+#ifndef SET_RATIO
+#define SET_RATIO 1
+#endif
+
+/* a contains per element vs join based set operations, m = n / SET_RATIO values against n */
+static void benchSetOps(int n)
+{
+	int m = n / SET_RATIO;
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, m);
+	struct BSTree *big = newBSTreeFlags(BST_INTKEY);
+	struct BSTree *small = newBSTreeFlags(BST_INTKEY);
+	for (int i = 0; i < n; i++)
+		addBSTree(big, &d[i]);
+	for (int i = 0; i < m; i++)
+		addBSTree(small, &q[i]);
+
+	/* what reconciling does today */
+	double t = now();
+	struct BSTree *tree = newBSTreeFlags(BST_INTKEY);
+	struct BSTreeIter it;
+	TYPE val;
+	bstIterBegin(small, &it);
+	while (bstIterNext(&it, &val))
+		if (containsBSTree(big, val))
+			addBSTree(tree, val);
+	report("contains loop intersect", m, m, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+
+	t = now();
+	tree = intersectBSTree(small, big);
+	report("intersectBSTree", m, m, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+	t = now();
+	tree = differenceBSTree(small, big);
+	report("differenceBSTree", m, m, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+	t = now();
+	tree = unionBSTree(big, small);
+	report("unionBSTree", n, n + m, now() - t, sizeBSTree(tree));
+	deleteBSTree(tree);
+
+	deleteBSTree(small);
+	deleteBSTree(big);
+	free(q);
+	free(d);
+}
+
+/* balanced vs self adjusting tree under uniform and skewed lookups */
+static void benchSplay(int n)
+{
+	struct data *d = makeData(n);
+	struct data **q = malloc(LOOKUPS * sizeof(struct data *));
+	double *cdf = malloc(n * sizeof(double));
+	const char *workloads[] = { "uniform", "zipf s=1", "1% hot, 90%" };
+	char name[64];
+
+	/* rank i of the Zipf law is d[i], which makeData already shuffled */
+	double sum = 0;
+	for (int i = 0; i < n; i++)
+		cdf[i] = sum += 1.0 / (i + 1);
+	for (int w = 0; w < 3; w++) {
+		for (int i = 0; i < LOOKUPS; i++) {
+			double u = (rng() >> 11) * (1.0 / 9007199254740992.0);
+			int k;
+			if (w == 0) {
+				k = rng() % n;
+			}
+			else if (w == 1) {
+				int lo = 0, hi = n - 1;
+				while (lo < hi) {
+					int mid = (lo + hi) / 2;
+					if (cdf[mid] < u * sum)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				k = lo;
+			}
+			else {
+				int hot = (n / 100 > 0) ? n / 100 : 1;
+				k = (u < 0.9) ? (int)(rng() % hot) : (int)(rng() % n);
+			}
+			q[i] = &d[k];
+		}
+
+		struct BSTree *tree = newBSTree();
+		struct SplayTree *splay = newSplayTree();
+		for (int i = 0; i < n; i++) {
+			addBSTree(tree, &d[i]);
+			addSplayTree(splay, &d[i]);
+		}
+		double t = now();
+		long found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsBSTree(tree, q[i]);
+		snprintf(name, sizeof(name), "AVL %s", workloads[w]);
+		report(name, n, LOOKUPS, now() - t, found);
+		t = now();
+		found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsSplayTree(splay, q[i]);
+		snprintf(name, sizeof(name), "splay %s", workloads[w]);
+		report(name, n, LOOKUPS, now() - t, found);
+		deleteSplayTree(splay);
+		deleteBSTree(tree);
+	}
+	free(cdf);
+	free(q);
+	free(d);
+}
+
+/* one node per value vs one node per distinct key, 8 values per key */
+static void benchMultiset(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n / 8, LOOKUPS);
+	int modes[] = { BST_INTKEY, BST_INTKEY | BST_MULTISET };
+	const char *names[] = { "INTKEY", "INTKEY|MULTISET" };
+	char name[64];
+
+	for (int i = 0; i < n; i++)
+		d[i].number /= 16;	/* numbers below n / 8, each 8 times */
+	for (int m = 0; m < 2; m++) {
+		struct BSTree *tree = newBSTreeFlags(modes[m]);
+		double t = now();
+		for (int i = 0; i < n; i++)
+			addBSTree(tree, &d[i]);
+		snprintf(name, sizeof(name), "add %s", names[m]);
+		report(name, n, n, now() - t, sizeBSTree(tree));
+
+		t = now();
+		long found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsBSTree(tree, &q[i]);
+		snprintf(name, sizeof(name), "contains %s", names[m]);
+		report(name, n, LOOKUPS, now() - t, found);
+
+		t = now();
+		for (int i = 0; i < n; i += 2)
+			removeBSTree(tree, &d[i]);
+		snprintf(name, sizeof(name), "remove %s", names[m]);
+		report(name, n, n / 2, now() - t, sizeBSTree(tree));
+		deleteBSTree(tree);
+	}
+	free(q);
+	free(d);
+}
+
+/* void* tree calling compare() vs trees generated by DEFINE_BSTREE */
+static void benchTemplate(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, LOOKUPS);
+	char name[64];
+
+	for (int m = 0; m < 2; m++) {
+		struct BSTree *tree = newBSTreeFlags(m ? BST_INTKEY : 0);
+		const char *mode = m ? "BSTree INTKEY" : "BSTree compare()";
+		double t = now();
+		for (int i = 0; i < n; i++)
+			addBSTree(tree, &d[i]);
+		snprintf(name, sizeof(name), "add %s", mode);
+		report(name, n, n, now() - t, sizeBSTree(tree));
+		t = now();
+		long found = 0;
+		for (int i = 0; i < LOOKUPS; i++)
+			found += containsBSTree(tree, &q[i]);
+		snprintf(name, sizeof(name), "contains %s", mode);
+		report(name, n, LOOKUPS, now() - t, found);
+		deleteBSTree(tree);
+	}
+
+	struct DataTree dataTree;
+	DataTreeInit(&dataTree);
+	double t = now();
+	for (int i = 0; i < n; i++)
+		DataTreeAdd(&dataTree, &d[i]);
+	report("add DataTree", n, n, now() - t, DataTreeSize(&dataTree));
+	t = now();
+	long found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += DataTreeContains(&dataTree, &q[i]);
+	report("contains DataTree", n, LOOKUPS, now() - t, found);
+	DataTreeClear(&dataTree);
+
+	struct IntTree intTree;
+	IntTreeInit(&intTree);
+	t = now();
+	for (int i = 0; i < n; i++)
+		IntTreeAdd(&intTree, d[i].number);
+	report("add IntTree", n, n, now() - t, IntTreeSize(&intTree));
+	t = now();
+	found = 0;
+	for (int i = 0; i < LOOKUPS; i++)
+		found += IntTreeContains(&intTree, q[i].number);
+	report("contains IntTree", n, LOOKUPS, now() - t, found);
+	IntTreeClear(&intTree);
+
+	/* the deque as a queue of n values, cycled LOOKUPS times */
+	struct DataDeque deque;
+	DataDequeInit(&deque);
+	for (int i = 0; i < n; i++)
+		DataDequeAddBack(&deque, &d[i]);
+	t = now();
+	found = 0;
+	for (int i = 0; i < LOOKUPS; i++) {
+		struct data *front = DataDequeFront(&deque);
+		DataDequeRemoveFront(&deque);
+		found += front->number & 1;
+		DataDequeAddBack(&deque, front);
+	}
+	report("cycle DataDeque", n, LOOKUPS, now() - t, found);
+	DataDequeClear(&deque);
+	free(q);
+	free(d);
+}
+
+/* full scan of the records vs the name index, exact and prefix lookups */
+static void countName(struct data *rec, void *arg)
+{
+	(void)rec;
+	(*(long *)arg)++;
+}
+
+static void benchNames(int n)
+{
+	struct data *d = makeData(n);
+	char (*names)[12] = malloc(n * sizeof(*names));
+	int scans = 200;
+	char prefix[4];
+
+	/* 8 letter names from a 16 letter alphabet */
+	for (int i = 0; i < n; i++) {
+		unsigned long long r = rng();
+		for (int k = 0; k < 8; k++)
+			names[i][k] = 'a' + ((r >> (4 * k)) & 15);
+		names[i][8] = '\0';
+		d[i].name = names[i];
+	}
+	struct NameIndex *index = newNameIndex();
+	double t = now();
+	for (int i = 0; i < n; i++)
+		addNameIndex(index, &d[i]);
+	report("add NameIndex", n, n, now() - t, sizeNameIndex(index));
+
+	t = now();
+	long found = 0;
+	for (int q = 0; q < scans; q++) {
+		const char *name = names[rng() % n];
+		for (int i = 0; i < n; i++)
+			found += strcmp(d[i].name, name) == 0;
+	}
+	report("exact scan", n, scans, now() - t, found);
+	t = now();
+	found = 0;
+	for (int q = 0; q < LOOKUPS; q++) {
+		struct data *out;
+		found += findNameIndex(index, names[rng() % n], &out, 1);
+	}
+	report("exact NameIndex", n, LOOKUPS, now() - t, found);
+
+	t = now();
+	found = 0;
+	for (int q = 0; q < scans; q++) {
+		memcpy(prefix, names[rng() % n], 3);
+		for (int i = 0; i < n; i++)
+			found += strncmp(d[i].name, prefix, 3) == 0;
+	}
+	report("prefix scan", n, scans, now() - t, found);
+	t = now();
+	found = 0;
+	for (int q = 0; q < scans; q++) {
+		memcpy(prefix, names[rng() % n], 3);
+		prefix[3] = '\0';
+		forEachPrefixNameIndex(index, prefix, countName, &found);
+	}
+	report("prefix NameIndex", n, scans, now() - t, found);
+	deleteNameIndex(index);
+	free(names);
+	free(d);
+}
+
+/* a printf per value vs the buffered writer, all output to /dev/null */
+static void benchExport(int n)
+{
+	struct data *d = makeData(n);
+	double *vals = malloc(n * sizeof(double));
+	const char *formats[] = { "text", "CSV", "binary" };
+	char name[64];
+
+	for (int i = 0; i < n; i++) {
+		d[i].name = (i % 3) ? "alpha" : "beta, gamma";
+		/* a mix of short decimals and full 17 digit values */
+		vals[i] = (i % 2) ? d[i].number / 8.0 : d[i].number / 7.0;
+	}
+	struct BSTree *tree = newBSTree();
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+	FILE *out = fopen("/dev/null", "w");
+	int fd = open("/dev/null", O_WRONLY);
+
+	struct BSTreeIter it;
+	TYPE val;
+	double t = now();
+	bstIterBegin(tree, &it);
+	while (bstIterNext(&it, &val))
+		fprintf(out, "%d,%s\n", ((struct data *)val)->number, ((struct data *)val)->name);
+	fflush(out);
+	report("CSV fprintf", n, n, now() - t, ftell(out));
+	for (int f = 0; f < 3; f++) {
+		struct Writer w;
+		t = now();
+		initWriterFd(&w, fd);
+		exportBSTree(tree, &w, f);
+		long bytes = finishWriter(&w);
+		snprintf(name, sizeof(name), "%s exportBSTree", formats[f]);
+		report(name, n, n, now() - t, bytes);
+	}
+
+	t = now();
+	for (int i = 0; i < n; i++)
+		fprintf(out, "%.17g\n", vals[i]);
+	fflush(out);
+	report("double fprintf %.17g", n, n, now() - t, 0);
+	struct Writer w;
+	t = now();
+	initWriterFd(&w, fd);
+	for (int i = 0; i < n; i++) {
+		writeDouble(&w, vals[i]);
+		writeChar(&w, '\n');
+	}
+	report("double writeDouble", n, n, now() - t, finishWriter(&w));
+	close(fd);
+	fclose(out);
+	deleteBSTree(tree);
+	free(vals);
+	free(d);
+}
+
+/* a full copy vs a shared snapshot, and what a live snapshot costs the writer */
+static void benchSnapshot(int n)
+{
+	struct data *d = makeData(n);
+	struct data *q = makeQueries(n, n);
+	TYPE *vals = malloc(n * sizeof(TYPE));
+	struct BSTree *tree = newBSTreeFlags(BST_INTKEY);
+	for (int i = 0; i < n; i++)
+		addBSTree(tree, &d[i]);
+
+	/* what a consistent copy for a reader costs today */
+	double t = now();
+	struct BSTree *copy = newBSTreeFlags(BST_INTKEY);
+	toArrayBSTree(tree, vals);
+	buildBSTreeFromSorted(copy, vals, sizeBSTree(tree));
+	report("toArray + build copy", n, 1, now() - t, sizeBSTree(copy));
+	deleteBSTree(copy);
+	t = now();
+	struct BSTree *snap = snapshotBSTree(tree);
+	report("snapshotBSTree", n, 1, now() - t, sizeBSTree(snap));
+	deleteBSTree(snap);
+
+	/* the same adds and removes without and with a snapshot live */
+	for (int pass = 0; pass < 2; pass++) {
+		snap = pass ? snapshotBSTree(tree) : 0;
+		t = now();
+		for (int i = 0; i < n; i++) {
+			addBSTree(tree, &q[i]);
+			removeBSTree(tree, &q[i]);
+		}
+		report(pass ? "add + remove, snapshot live" : "add + remove", n, 2 * n,
+		       now() - t, sizeBSTree(tree));
+		if (snap != 0) {
+			struct Stats stats;
+			getStatsBSTree(snap, &stats);
+			printf("  snapshot kept %ld values\n", stats.size);
+			t = now();
+			deleteBSTree(snap);
+			report("  delete snapshot", n, 1, now() - t, 0);
+		}
+	}
+	deleteBSTree(tree);
+	free(vals);
+	free(q);
+	free(d);
+}
+
+struct bench {
+	const char *name;
+	void (*run)(int n);
+};
+
+static struct bench benches[] = {
+	{ "frozen", benchFrozen },
+	{ "btree", benchBTree },
+	{ "intkey", benchIntKey },
+	{ "readers", benchReaders },
+	{ "writers", benchWriters },
+	{ "linearize", benchLinearize },
+	{ "batch", benchBatch },
+	{ "mapped", benchMapped },
+	{ "setops", benchSetOps },
+	{ "splay", benchSplay },
+	{ "multiset", benchMultiset },
+	{ "template", benchTemplate },
+	{ "names", benchNames },
+	{ "export", benchExport },
+	{ "snapshot", benchSnapshot },
+};
+
+int main(int argc, char **argv)
+{
+	int count = sizeof(benches) / sizeof(benches[0]);
+	int n = (argc > 2) ? atoi(argv[2]) : 1000000;
+	for (int i = 0; i < count; i++) {
+		if (argc > 1 && strcmp(argv[1], benches[i].name) == 0) {
+			benches[i].run(n);
+			return failures != 0;
+		}
+	}
+	printf("usage: %s <benchmark> [n]\nbenchmarks:", argv[0]);
+	for (int i = 0; i < count; i++)
+		printf(" %s", benches[i].name);
+	printf("\n");
+	return 1;
+}
@@ -0,0 +1,230 @@
+/*
+  File: bstTemplate.h
+  Code generating version of the AVL tree in bst.c.  bst.h fixes one TYPE
+  for the whole program and reaches compare() through an out of line call.
+  DEFINE_BSTREE(name, T, cmp) instead writes out a tree of T values whose
+  functions are all static inline and start with name, so trees of several
+  element types can live in one program and cmp is inlined at every use.
+
+  cmp(a, b) is a function or function-like macro that returns <0, 0 or >0
+  like compare(); TEMPLATE_COMPARE does this for any arithmetic T.  As in
+  bst.c, equal values are all kept.
+
+  Example:
+	DEFINE_BSTREE(IntTree, int, TEMPLATE_COMPARE)
+
+	struct IntTree tree;
+	IntTreeInit(&tree);
+	IntTreeAdd(&tree, 5);
+	if (IntTreeContains(&tree, 5)) ...
+	IntTreeClear(&tree);
+
+  The generated functions are:
+	void nameInit(struct name *tree);
+	void nameClear(struct name *tree);
+	int  nameIsEmpty(struct name *tree);
+	int  nameSize(struct name *tree);
+	void nameAdd(struct name *tree, T val);
+	int  nameContains(struct name *tree, T val);
+	void nameRemove(struct name *tree, T val);
+*/
+
+#ifndef __BST_TEMPLATE_H
+#define __BST_TEMPLATE_H
+
+#include <stdlib.h>
+#include <assert.h>
+
+/* three way comparison of two arithmetic values, without overflow */
+#define TEMPLATE_COMPARE(A, B) (((A) > (B)) - ((A) < (B)))
+
+#define DEFINE_BSTREE(name, T, cmp)					\
+									\
+struct name##Node {							\
+	T                  val;						\
+	struct name##Node *left;					\
+	struct name##Node *right;					\
+	int                height;					\
+};									\
+									\
+struct name {								\
+	struct name##Node *root;					\
+	int                cnt;						\
+};									\
+									\
+static inline void name##Init(struct name *tree)			\
+{									\
+	tree->root = 0;							\
+	tree->cnt = 0;							\
+}									\
+									\
+/* rotate left children up until a node has none, then it can go */	\
+static inline void name##Clear(struct name *tree)			\
+{									\
+	struct name##Node *cur = tree->root;				\
+	while (cur != 0) {						\
+		if (cur->left != 0) {					\
+			struct name##Node *left = cur->left;		\
+			cur->left = left->right;			\
+			left->right = cur;				\
+			cur = left;					\
+		}							\
+		else {							\
+			struct name##Node *next = cur->right;		\
+			free(cur);					\
+			cur = next;					\
+		}							\
+	}								\
+	name##Init(tree);						\
+}									\
+									\
+static inline int name##IsEmpty(struct name *tree)			\
+{									\
+	return tree->cnt == 0;						\
+}									\
+									\
+static inline int name##Size(struct name *tree)				\
+{									\
+	return tree->cnt;						\
+}									\
+									\
+static inline int name##_height(struct name##Node *cur)			\
+{									\
+	return (cur == 0) ? 0 : cur->height;				\
+}									\
+									\
+static inline void name##_update(struct name##Node *cur)		\
+{									\
+	int left = name##_height(cur->left);				\
+	int right = name##_height(cur->right);				\
+	cur->height = 1 + (left > right ? left : right);		\
+}									\
+									\
+static inline struct name##Node *name##_rotateRight(struct name##Node *cur) \
+{									\
+	struct name##Node *pivot = cur->left;				\
+	cur->left = pivot->right;					\
+	pivot->right = cur;						\
+	name##_update(cur);						\
+	name##_update(pivot);						\
+	return pivot;							\
+}									\
+									\
+static inline struct name##Node *name##_rotateLeft(struct name##Node *cur) \
+{									\
+	struct name##Node *pivot = cur->right;				\
+	cur->right = pivot->left;					\
+	pivot->left = cur;						\
+	name##_update(cur);						\
+	name##_update(pivot);						\
+	return pivot;							\
+}									\
+									\
+/* restore the AVL property after a subtree changed by one level */	\
+static inline struct name##Node *name##_balance(struct name##Node *cur)	\
+{									\
+	name##_update(cur);						\
+	int diff = name##_height(cur->left) - name##_height(cur->right); \
+	if (diff > 1) {							\
+		if (name##_height(cur->left->left) <			\
+		    name##_height(cur->left->right)) {			\
+			cur->left = name##_rotateLeft(cur->left);	\
+		}							\
+		return name##_rotateRight(cur);				\
+	}								\
+	if (diff < -1) {						\
+		if (name##_height(cur->right->right) <			\
+		    name##_height(cur->right->left)) {			\
+			cur->right = name##_rotateRight(cur->right);	\
+		}							\
+		return name##_rotateLeft(cur);				\
+	}								\
+	return cur;							\
+}									\
+									\
+static inline struct name##Node *name##_addNode(struct name##Node *cur,	\
+						T val)			\
+{									\
+	if (cur == 0) {							\
+		struct name##Node *new = malloc(sizeof(struct name##Node)); \
+		assert(new != 0);					\
+		new->val = val;						\
+		new->left = new->right = 0;				\
+		new->height = 1;					\
+		return new;						\
+	}								\
+	if (cmp(val, cur->val) >= 0) {					\
+		cur->right = name##_addNode(cur->right, val);		\
+	}								\
+	else {								\
+		cur->left = name##_addNode(cur->left, val);		\
+	}								\
+	return name##_balance(cur);					\
+}									\
+									\
+static inline void name##Add(struct name *tree, T val)			\
+{									\
+	tree->root = name##_addNode(tree->root, val);			\
+	tree->cnt++;							\
+}									\
+									\
+static inline int name##Contains(struct name *tree, T val)		\
+{									\
+	struct name##Node *cur = tree->root;				\
+	while (cur != 0) {						\
+		int c = cmp(val, cur->val);				\
+		if (c == 0) {						\
+			return 1;					\
+		}							\
+		cur = (c < 0) ? cur->left : cur->right;			\
+	}								\
+	return 0;							\
+}									\
+									\
+static inline struct name##Node *name##_removeLeftMost(			\
+	struct name##Node *cur, T *val)					\
+{									\
+	if (cur->left == 0) {						\
+		struct name##Node *right = cur->right;			\
+		*val = cur->val;					\
+		free(cur);						\
+		return right;						\
+	}								\
+	cur->left = name##_removeLeftMost(cur->left, val);		\
+	return name##_balance(cur);					\
+}									\
+									\
+/* sets *found when a node equal to val was taken out */		\
+static inline struct name##Node *name##_removeNode(			\
+	struct name##Node *cur, T val, int *found)			\
+{									\
+	if (cur == 0) {							\
+		return 0;						\
+	}								\
+	int c = cmp(val, cur->val);					\
+	if (c == 0) {							\
+		*found = 1;						\
+		if (cur->right == 0) {					\
+			struct name##Node *left = cur->left;		\
+			free(cur);					\
+			return left;					\
+		}							\
+		cur->right = name##_removeLeftMost(cur->right, &cur->val); \
+	}								\
+	else if (c < 0) {						\
+		cur->left = name##_removeNode(cur->left, val, found);	\
+	}								\
+	else {								\
+		cur->right = name##_removeNode(cur->right, val, found);	\
+	}								\
+	return name##_balance(cur);					\
+}									\
+									\
+static inline void name##Remove(struct name *tree, T val)		\
+{									\
+	int found = 0;							\
+	tree->root = name##_removeNode(tree->root, val, &found);	\
+	tree->cnt -= found;						\
+}
+
+# endif
@@ -0,0 +1,485 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: btree.c
+*
+* Solution description: Implementation of a B-tree bag that
+* stores values ordered by their key_type() integer.  The
+* keys of a node are copied into a cache line aligned int
+* array and the position of a key inside a node is found by
+* comparing all slots at once with SSE2 or AVX2, then
+* counting the slots that hold smaller keys.
+* Insert splits full nodes and remove refills thin nodes on
+* the way down (CLRS style), so both are a single descent.
+************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "btree.h"
+
+# if defined(__AVX2__) || defined(__SSE2__)
+# include <immintrin.h>
+# endif
+
+# define MIN_KEYS   (BTREE_ORDER - 1)
+# define MAX_KEYS   (2 * BTREE_ORDER - 1)
+# define KEY_SLOTS  (2 * BTREE_ORDER)
+
+/* _rank keeps one bit per slot in an unsigned int and compares 8 slots at
+ * a time with AVX2. */
+# if BTREE_ORDER < 4 || BTREE_ORDER > 16 || BTREE_ORDER % 4 != 0
+# error "BTREE_ORDER must be 4, 8, 12 or 16"
+# endif
+
+struct BTreeNode {
+	_Alignas(64) int  keys[KEY_SLOTS];	/* keys[0..n-1], the rest is padding */
+	int               n;
+	int               leaf;
+	TYPE              vals[MAX_KEYS];
+	struct BTreeNode *child[MAX_KEYS + 1];
+};
+
+struct BTree {
+	struct BTreeNode *root;
+	int               cnt;
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to allocate an empty node
+ param:	leaf	1 if the node is a leaf
+ post:	node is cache line aligned with n = 0
+ */
+static struct BTreeNode *_newNode(int leaf)
+{
+    struct BTreeNode *node = aligned_alloc(64, sizeof(struct BTreeNode));
+    assert(node != 0);
+    node->n = 0;
+    node->leaf = leaf;
+    return node;
+}
+
+/*
+ helper function to count the keys in a node that are smaller than key,
+ which is also the index of the first key that is not smaller
+ param:	node	the node to search
+		key		the key to search for
+ */
+static int _rank(const struct BTreeNode *node, int key)
+{
+    unsigned int mask = 0;
+    int i;
+# if defined(__AVX2__)
+    __m256i needle = _mm256_set1_epi32(key);
+    for (i = 0; i < KEY_SLOTS; i += 8) {
+        __m256i slots = _mm256_load_si256((const __m256i *)(node->keys + i));
+        __m256i less = _mm256_cmpgt_epi32(needle, slots);
+        mask |= (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(less)) << i;
+    }
+# elif defined(__SSE2__)
+    __m128i needle = _mm_set1_epi32(key);
+    for (i = 0; i < KEY_SLOTS; i += 4) {
+        __m128i slots = _mm_load_si128((const __m128i *)(node->keys + i));
+        __m128i less = _mm_cmplt_epi32(slots, needle);
+        mask |= (unsigned int)_mm_movemask_ps(_mm_castsi128_ps(less)) << i;
+    }
+# else
+    for (i = 0; i < KEY_SLOTS; i++) {
+        mask |= (unsigned int)(node->keys[i] < key) << i;
+    }
+# endif
+    //ignore the padding slots, the keys are sorted so the rest is a prefix
+    mask &= (1u << node->n) - 1;
+    return __builtin_popcount(mask);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to initialize the B-tree.
+ param: tree
+ pre: tree is not null
+ post:	tree size is 0
+		root is null
+ */
+void initBTree(struct BTree *tree)
+{
+    tree->cnt  = 0;
+    tree->root = 0;
+}
+
+/*
+ function to create a B-tree.
+ param: none
+ pre: none
+ post: tree->count = 0
+	tree->root = 0;
+ */
+struct BTree *newBTree()
+{
+    struct BTree *tree = malloc(sizeof(struct BTree));
+    assert(tree != 0);
+    initBTree(tree);
+    return tree;
+}
+
+/*
+ helper function to free a node and its descendants
+ param: node	the root of the subtree to be freed
+ */
+static void _freeBTree(struct BTreeNode *node)
+{
+    if (node != 0) {
+        if (!node->leaf) {
+            for (int i = 0; i <= node->n; i++) {
+                _freeBTree(node->child[i]);
+            }
+        }
+        free(node);
+    }
+}
+
+/*
+ function to clear the nodes of a B-tree
+ param: tree    a B-tree
+ pre: tree is not null
+ post: the nodes of the tree are deallocated
+		root is NULL
+		tree size is 0
+ */
+void clearBTree(struct BTree *tree)
+{
+    _freeBTree(tree->root);
+    tree->root = 0;
+    tree->cnt = 0;
+}
+
+/*
+ function to deallocate a dynamically allocated B-tree
+ param: tree   the B-tree
+ pre: tree is not null
+ post: all nodes and the tree structure itself are deallocated.
+ */
+void deleteBTree(struct BTree *tree)
+{
+    clearBTree(tree);
+    free(tree);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to determine if a B-tree is empty.
+ param: tree    the B-tree
+ pre:  tree is not null
+ */
+int isEmptyBTree(struct BTree *tree)
+{
+    return (tree->cnt == 0);
+}
+
+/*
+ function to determine the size of a B-tree
+ param: tree    the B-tree
+ pre:  tree is not null
+ */
+int sizeBTree(struct BTree *tree)
+{
+    return tree->cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to move entries inside a node
+ param:	node	the node
+		to		destination index
+		from	source index
+		count	number of keys (and values) to move
+ */
+static void _moveEntries(struct BTreeNode *node, int to, int from, int count)
+{
+    if (count > 0) {
+        memmove(&node->keys[to], &node->keys[from], count * sizeof(int));
+        memmove(&node->vals[to], &node->vals[from], count * sizeof(TYPE));
+    }
+}
+
+/*
+ helper function to move child pointers inside a node
+ param:	node	the node
+		to		destination index
+		from	source index
+		count	number of children to move
+ */
+static void _moveChildren(struct BTreeNode *node, int to, int from, int count)
+{
+    if (count > 0) {
+        memmove(&node->child[to], &node->child[from], count * sizeof(struct BTreeNode *));
+    }
+}
+
+/*
+ helper function to split a full child in two, moving its median up
+ param:	parent	a node that is not full
+		i		index of the full child
+ post:	parent->child[i] and parent->child[i+1] hold MIN_KEYS keys each
+ */
+static void _splitChild(struct BTreeNode *parent, int i)
+{
+    struct BTreeNode *full = parent->child[i];
+    struct BTreeNode *right = _newNode(full->leaf);
+    //upper half of full goes to the new right sibling
+    right->n = MIN_KEYS;
+    memcpy(right->keys, &full->keys[BTREE_ORDER], MIN_KEYS * sizeof(int));
+    memcpy(right->vals, &full->vals[BTREE_ORDER], MIN_KEYS * sizeof(TYPE));
+    if (!full->leaf) {
+        memcpy(right->child, &full->child[BTREE_ORDER], BTREE_ORDER * sizeof(struct BTreeNode *));
+    }
+    full->n = MIN_KEYS;
+    //make room in the parent for the median and the new child
+    _moveChildren(parent, i + 2, i + 1, parent->n - i);
+    _moveEntries(parent, i + 1, i, parent->n - i);
+    parent->child[i + 1] = right;
+    parent->keys[i] = full->keys[MIN_KEYS];
+    parent->vals[i] = full->vals[MIN_KEYS];
+    parent->n++;
+}
+
+/*
+ function to add a value to the B-tree
+ param: tree   the B-tree
+		val		the value to be added to the tree
+ pre:	tree is not null
+		val is not null
+ post:  tree size increased by 1
+		tree now contains the value, val
+ */
+void addBTree(struct BTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    int key = key_type(val);
+    if (tree->root == 0) {
+        tree->root = _newNode(1);
+    }
+    //a full root is split first, which is the only way the tree grows taller
+    if (tree->root->n == MAX_KEYS) {
+        struct BTreeNode *root = _newNode(0);
+        root->child[0] = tree->root;
+        tree->root = root;
+        _splitChild(root, 0);
+    }
+    //walk down splitting full children so there is always room below
+    struct BTreeNode *cur = tree->root;
+    while (!cur->leaf) {
+        int i = _rank(cur, key);
+        if (cur->child[i]->n == MAX_KEYS) {
+            _splitChild(cur, i);
+            if (cur->keys[i] < key) {
+                i++;
+            }
+        }
+        cur = cur->child[i];
+    }
+    int i = _rank(cur, key);
+    _moveEntries(cur, i + 1, i, cur->n - i);
+    cur->keys[i] = key;
+    cur->vals[i] = val;
+    cur->n++;
+    tree->cnt++;
+}
+
+/*
+ function to determine if the B-tree contains a value with the same key
+ param:	tree	the B-tree
+		val		the value to search for in the tree
+ pre:	tree is not null
+		val is not null
+ post:	return 1 if found, else return 0 if not found
+ */
+int containsBTree(struct BTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    int key = key_type(val);
+    struct BTreeNode *cur = tree->root;
+    while (cur != 0) {
+        int i = _rank(cur, key);
+        if (i < cur->n && cur->keys[i] == key) {
+            return 1;
+        }
+        cur = cur->leaf ? 0 : cur->child[i];
+    }
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to merge child i+1 and the separator key i into child i
+ param:	parent	the parent node
+		i		index of the left child
+ pre:	both children hold MIN_KEYS keys
+ post:	child i holds MAX_KEYS keys and child i+1 is freed
+ */
+static void _mergeChildren(struct BTreeNode *parent, int i)
+{
+    struct BTreeNode *left = parent->child[i];
+    struct BTreeNode *right = parent->child[i + 1];
+    left->keys[left->n] = parent->keys[i];
+    left->vals[left->n] = parent->vals[i];
+    memcpy(&left->keys[left->n + 1], right->keys, right->n * sizeof(int));
+    memcpy(&left->vals[left->n + 1], right->vals, right->n * sizeof(TYPE));
+    if (!left->leaf) {
+        memcpy(&left->child[left->n + 1], right->child, (right->n + 1) * sizeof(struct BTreeNode *));
+    }
+    left->n += right->n + 1;
+    //close the gap in the parent
+    _moveEntries(parent, i, i + 1, parent->n - i - 1);
+    _moveChildren(parent, i + 1, i + 2, parent->n - i - 1);
+    parent->n--;
+    free(right);
+}
+
+/*
+ helper function to make sure a child has more than MIN_KEYS keys before
+ the removal descends into it, borrowing from a sibling or merging
+ param:	parent	the parent node
+		i		index of the child about to be visited
+ post:	returns the index of the child to visit, which moves to i-1 when
+		the child was merged into its left sibling
+ */
+static int _fillChild(struct BTreeNode *parent, int i)
+{
+    struct BTreeNode *cur = parent->child[i];
+    if (cur->n > MIN_KEYS) {
+        return i;
+    }
+    //borrow through the parent from the left sibling
+    if (i > 0 && parent->child[i - 1]->n > MIN_KEYS) {
+        struct BTreeNode *left = parent->child[i - 1];
+        _moveEntries(cur, 1, 0, cur->n);
+        cur->keys[0] = parent->keys[i - 1];
+        cur->vals[0] = parent->vals[i - 1];
+        if (!cur->leaf) {
+            _moveChildren(cur, 1, 0, cur->n + 1);
+            cur->child[0] = left->child[left->n];
+        }
+        parent->keys[i - 1] = left->keys[left->n - 1];
+        parent->vals[i - 1] = left->vals[left->n - 1];
+        left->n--;
+        cur->n++;
+        return i;
+    }
+    //borrow through the parent from the right sibling
+    if (i < parent->n && parent->child[i + 1]->n > MIN_KEYS) {
+        struct BTreeNode *right = parent->child[i + 1];
+        cur->keys[cur->n] = parent->keys[i];
+        cur->vals[cur->n] = parent->vals[i];
+        if (!cur->leaf) {
+            cur->child[cur->n + 1] = right->child[0];
+            _moveChildren(right, 0, 1, right->n);
+        }
+        parent->keys[i] = right->keys[0];
+        parent->vals[i] = right->vals[0];
+        _moveEntries(right, 0, 1, right->n - 1);
+        right->n--;
+        cur->n++;
+        return i;
+    }
+    //both siblings are thin, merge with one of them
+    if (i < parent->n) {
+        _mergeChildren(parent, i);
+        return i;
+    }
+    _mergeChildren(parent, i - 1);
+    return i - 1;
+}
+
+/*
+ helper function to remove the largest (or smallest) entry of a subtree
+ param:	cur		root of the subtree, holding more than MIN_KEYS keys
+		last	1 to remove the largest entry, 0 for the smallest
+		key		receives the removed key
+ post:	returns the removed value
+ */
+static TYPE _removeEnd(struct BTreeNode *cur, int last, int *key)
+{
+    while (!cur->leaf) {
+        cur = cur->child[_fillChild(cur, last ? cur->n : 0)];
+    }
+    TYPE val;
+    if (last) {
+        *key = cur->keys[cur->n - 1];
+        val = cur->vals[cur->n - 1];
+    }
+    else {
+        *key = cur->keys[0];
+        val = cur->vals[0];
+        _moveEntries(cur, 0, 1, cur->n - 1);
+    }
+    cur->n--;
+    return val;
+}
+
+/*
+ helper function to remove one entry with the given key from a subtree
+ param:	cur		root of the subtree
+		key		the key to remove
+ pre:	cur is the root or holds more than MIN_KEYS keys
+ post:	return 1 if an entry was removed, else 0
+ */
+static int _removeKey(struct BTreeNode *cur, int key)
+{
+    for (;;) {
+        int i = _rank(cur, key);
+        if (i < cur->n && cur->keys[i] == key) {
+            //found in a leaf, just close the gap
+            if (cur->leaf) {
+                _moveEntries(cur, i, i + 1, cur->n - i - 1);
+                cur->n--;
+                return 1;
+            }
+            //replace with the predecessor or successor from a child that can spare one
+            if (cur->child[i]->n > MIN_KEYS) {
+                cur->vals[i] = _removeEnd(cur->child[i], 1, &cur->keys[i]);
+                return 1;
+            }
+            if (cur->child[i + 1]->n > MIN_KEYS) {
+                cur->vals[i] = _removeEnd(cur->child[i + 1], 0, &cur->keys[i]);
+                return 1;
+            }
+            //otherwise pull the key down into the merged child and keep going
+            _mergeChildren(cur, i);
+            cur = cur->child[i];
+            continue;
+        }
+        if (cur->leaf) {
+            return 0;
+        }
+        cur = cur->child[_fillChild(cur, i)];
+    }
+}
+
+/*
+ function to remove a value from the B-tree
+ param: tree   the B-tree
+		val		the value to be removed from the tree
+ pre:	tree is not null
+		val is not null
+ post:	if a value with the same key was in the tree, one such value is
+		removed and the tree size is reduced by 1
+ */
+void removeBTree(struct BTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    if (tree->root == 0) {
+        return;
+    }
+    if (_removeKey(tree->root, key_type(val))) {
+        tree->cnt--;
+    }
+    //a root emptied by a merge hands over to its only child
+    struct BTreeNode *root = tree->root;
+    if (root->n == 0) {
+        tree->root = root->leaf ? 0 : root->child[0];
+        free(root);
+    }
+}
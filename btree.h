@@ -0,0 +1,49 @@
+/*
+  File: btree.h
+  Interface definition of a B-tree with the same bag operations as bst.h.
+  Each node keeps its int keys (key_type(), i.e. struct data.number) packed
+  in one or two cache lines so a lookup fetches far fewer lines than a
+  binary tree.
+*/
+
+#ifndef __BTREE_H
+#define __BTREE_H
+
+# ifndef TYPE
+# define TYPE      void*
+# endif
+
+/* Minimum degree t: nodes hold t-1 to 2t-1 keys in 2t int slots, so 8
+ * fills one 64 byte line and 16 fills two.  Must be a multiple of 4 and
+ * at most 16, as a node's slots are compared into a 32 bit mask. */
+# ifndef BTREE_ORDER
+# define BTREE_ORDER 8
+# endif
+
+/* function used to get the integer key of TYPE values, define this in your
+   compare.c file (see key_type in bst.h) */
+int key_type(TYPE curval);
+
+struct BTree;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Initialize B-tree structure. */
+void initBTree(struct BTree *tree);
+
+/* Alocate and initialize B-tree structure. */
+struct BTree *newBTree();
+
+/* Deallocate nodes in the B-tree. */
+void clearBTree(struct BTree *tree);
+
+/* Deallocate nodes in the B-tree and deallocate the B-tree structure. */
+void deleteBTree(struct BTree *tree);
+
+/*-- B-tree Bag interface --*/
+int  isEmptyBTree(struct BTree *tree);
+int     sizeBTree(struct BTree *tree);
+
+void     addBTree(struct BTree *tree, TYPE val);
+int containsBTree(struct BTree *tree, TYPE val);
+void  removeBTree(struct BTree *tree, TYPE val);
+# endif
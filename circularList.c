@@ -18,17 +18,27 @@
 *	Note that this implementation uses double links (links with
 *	next and prev pointers) and that given that it is a circular
 *	linked deque the last link points to the Sentinel and the first
-*	link points to the Sentinel -- instead of null.
+*	link points to the Sentinel -- instead of null.  Links, the
+*	sentinel included, come from a pool of slabs owned by the
+*	deque (see linkPool.h).
 ************************************************************/
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
 #include "circularList.h"
+#include "writer.h"
+#include "linkPool.h"
 
 #ifndef FORMAT_SPECIFIER
 #define FORMAT_SPECIFIER "%g"
 #endif
 
+// Writes one TYPE value for circularListExport
+#ifndef WRITE_TYPE
+#define WRITE_TYPE(W, V) writeDouble(W, V)
+#endif
+
 // Double link
 struct Link
 {
@@ -41,6 +51,10 @@ struct CircularList
 {
 	int size;
 	struct Link* sentinel;
+	struct LinkPool pool;	// slabs every link of this deque comes from
+#ifdef COLLECT_STATS
+	struct Stats stats;
+#endif
 };
 
 /**
@@ -57,8 +71,9 @@ static void init(struct CircularList* deque)
 {
     //deque is not null
     assert(deque != 0);
-    //allocate space for the sentinel
-    deque->sentinel = malloc(sizeof(struct Link));
+    //allocate space for the sentinel from the deque's own pool
+    linkPoolInit(&deque->pool, sizeof(struct Link), LINK_POOL_HIGH_WATER);
+    deque->sentinel = linkPoolAlloc(&deque->pool);
     //confirm sentinel is not null
     assert(deque->sentinel != 0);
     //sentinel next points to itself
@@ -67,20 +82,25 @@ static void init(struct CircularList* deque)
     deque->sentinel->prev = deque->sentinel;
     //set deque size to zero
     deque->size = 0;
+#ifdef COLLECT_STATS
+    //start the counters at zero
+    memset(&deque->stats, 0, sizeof(deque->stats));
+#endif
 }
 
 /**
 	Creates a link with the given value and NULL next and prev pointers.
+	param: 	deque 	struct CircularList ptr
 	param: 	value 	TYPE
-	pre: 	         none
+	pre: 	         deque is not null
 	post: 	newLink is not null
 			newLink value init to value
 			newLink next and prev init to NULL
  */
-static struct Link* createLink(TYPE value)
+static struct Link* createLink(struct CircularList* deque, TYPE value)
 {
-    //create new Link
-    struct Link *newLink = malloc(sizeof(struct Link));
+    //create new Link from the deque's pool
+    struct Link *newLink = linkPoolAlloc(&deque->pool);
     //newLink is not null
     assert(newLink != 0);
     //value in newLink is set to param value
@@ -107,7 +127,7 @@ static void addLinkAfter(struct CircularList* deque, struct Link* link, TYPE val
     //deque and link are not null
     assert(deque != 0 && link != 0);
     //create new link with given value
-    struct Link *new = createLink(value);
+    struct Link *new = createLink(deque, value);
     //new link is not null
     assert(new != 0);
     //insert new link after given link
@@ -121,6 +141,8 @@ static void addLinkAfter(struct CircularList* deque, struct Link* link, TYPE val
     link->next = new;
     //increment deque size by 1
     deque->size++;
+    STAT_INC(deque->stats.adds);
+    STAT_INC(deque->stats.allocated);
 }
 
 /**
@@ -129,7 +151,7 @@ static void addLinkAfter(struct CircularList* deque, struct Link* link, TYPE val
  	param:	link 	struct Link ptr
 	pre: 	deque and link are not null
 	post: 	param link is removed from param deque
-			memory allocated to link is freed
+			link is given back to the pool
 			deque size is decremented by 1
  */
 static void removeLink(struct CircularList* deque, struct Link* link)
@@ -140,11 +162,13 @@ static void removeLink(struct CircularList* deque, struct Link* link)
     link->prev->next = link->next;
     //point link after param to link prior to param
     link->next->prev = link->prev;
-    //free param link memory
-    free(link);
+    //give param link back to the pool
+    linkPoolFree(&deque->pool, link);
     link = 0;
     //decrement deque size by 1
     deque->size--;
+    STAT_INC(deque->stats.removes);
+    STAT_INC(deque->stats.freed);
 }
 
 /**
@@ -164,7 +188,7 @@ struct CircularList* circularListCreate()
 /**
 	Deallocates every link in the deque and frees the deque pointer.
 	pre: 	deque is not null
-	post: 	memory allocated to each link is freed
+	post: 	memory allocated to each link is freed, a slab at a time
 			" " sentinel " "
 			" " deque " "
  */
@@ -173,20 +197,9 @@ void circularListDestroy(struct CircularList* deque)
 {
     //deque is not null
     assert(deque != 0);
-    //remove links until deque has size zero
-    //move forward one while still maintaining the prior to remove
-    struct Link* remove = 0;
-    struct Link* position = deque->sentinel->next;
-    while (deque->size != 0) {
-        //set the one to remove
-        remove = position;
-        //move to the next one
-        position = position->next;
-        //delete the prior one
-        removeLink(deque, remove);
-    }
-    //free memory allocated for sentinel
-    free(deque->sentinel);
+    STAT_ADD(deque->stats.freed, deque->size);
+    //free the slabs holding every link and the sentinel
+    linkPoolDestroy(&deque->pool);
     //free memory allocated for deque
     free(deque);
     deque = 0;
@@ -362,3 +375,59 @@ void circularListReverse(struct CircularList* deque)
         temp = current->next;
     } while (current != deque->sentinel);
 }
+
+/**
+	Writes the values of the links from front to back.
+	param:	deque	struct CircularList ptr
+	param:	w	struct Writer ptr, see writer.h
+	param:	format	EXPORT_TEXT or EXPORT_CSV for one value per line,
+			EXPORT_BINARY for the raw TYPE values
+	pre:	deque and w are not null
+	post:	values are written through w (call to finishWriter to flush)
+	ret:	the number of values written
+ */
+int circularListExport(struct CircularList* deque, struct Writer* w, int format)
+{
+    //deque and w are not null
+    assert(deque != 0 && w != 0);
+    struct Link *placeHolder = deque->sentinel->next;
+    while (placeHolder != deque->sentinel) {
+        if (format == EXPORT_BINARY) {
+            writeBytes(w, &placeHolder->value, sizeof(TYPE));
+        }
+        //text and CSV are the same with one column
+        else {
+            WRITE_TYPE(w, placeHolder->value);
+            writeChar(w, '\n');
+        }
+        placeHolder = placeHolder->next;
+    }
+    return deque->size;
+}
+
+/**
+	Fills in the statistics of the deque.
+	param:	deque	struct CircularList ptr
+	param:	stats	struct Stats ptr
+	pre:	deque and stats are not null
+	post:	counters are copied if built with COLLECT_STATS, otherwise 0;
+			size, links and bytes are measured; height and avgDepth
+			are 0
+ */
+void circularListGetStats(struct CircularList* deque, struct Stats* stats)
+{
+    //deque and stats are not null
+    assert(deque != 0 && stats != 0);
+#ifdef COLLECT_STATS
+    *stats = deque->stats;
+#else
+    memset(stats, 0, sizeof(struct Stats));
+#endif
+    //every value has a link of its own
+    stats->size = deque->size;
+    stats->nodes = deque->size;
+    //the slabs holding the links and the deque itself
+    stats->bytes = sizeof(struct CircularList) + linkPoolBytes(&deque->pool);
+    stats->height = 0;
+    stats->avgDepth = 0;
+}
@@ -1,6 +1,9 @@
 #ifndef CIRCULAR_LIST_H
 #define CIRCULAR_LIST_H
 
+// Links come from slabs owned by each list, link with linkPool.c and
+// writer.c too
+
 #ifndef TYPE
 #define TYPE double
 #endif
@@ -13,6 +16,8 @@
 #define EQ(A, B) ((A) == (B))
 #endif
 
+#include "stats.h"
+
 struct CircularList;
 
 struct CircularList* circularListCreate(void);
@@ -30,4 +35,13 @@ void circularListRemoveFront(struct CircularList* list);
 void circularListRemoveBack(struct CircularList* list);
 int circularListIsEmpty(struct CircularList* list);
 
+// Export, see writer.h for the formats
+
+struct Writer;
+int circularListExport(struct CircularList* list, struct Writer* w, int format);
+
+// Statistics, counters need -DCOLLECT_STATS (see stats.h)
+
+void circularListGetStats(struct CircularList* list, struct Stats* stats);
+
 #endif
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <assert.h>
+#include <string.h>
 #include "bst.h"
 #include "structs.h"
+#include "writer.h"
 
 /*----------------------------------------------------------------------------
  very similar to the compareTo method in java or the strcmp function in c. it
@@ -49,4 +51,40 @@ void print_type(TYPE curval)
     printf("%d",returnVal->number);
 }
 
+/*Define this function, type casting the value of void * to the desired type.
+  Trees created with BST_INTKEY call it once per value and compare the
+  returned integers instead of calling compare(), so it has to order values
+  exactly the way compare() does.*/
+int key_type(TYPE curval)
+{
+    //type casting to desired type
+    struct data* keyVal = (struct data*) curval;
+    //compare() orders by the number
+    return keyVal->number;
+}
 
+/*Define this function, type casting the value of void * to the desired type.
+  Text is the number on a line of its own, CSV is number,name and binary is
+  the number and the length of the name as 32 bit ints (-1 for no name)
+  followed by the bytes of the name.*/
+void export_type(TYPE curval, struct Writer *w, int format)
+{
+    //type casting to desired type
+    struct data* rec = (struct data*) curval;
+    if (format == EXPORT_BINARY) {
+        int header[2];
+        header[0] = rec->number;
+        header[1] = (rec->name == 0) ? -1 : (int)strlen(rec->name);
+        writeBytes(w, header, sizeof(header));
+        if (rec->name != 0) {
+            writeBytes(w, rec->name, header[1]);
+        }
+        return;
+    }
+    writeInt(w, rec->number);
+    if (format == EXPORT_CSV) {
+        writeChar(w, ',');
+        writeCsvField(w, rec->name);
+    }
+    writeChar(w, '\n');
+}
@@ -0,0 +1,265 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: concurrentQueue.c
+*
+* Solution description: Michael and Scott's lock-free queue.
+* The list always starts with a dummy node whose successor
+* is the front; enqueue links a node after the last one with
+* a compare and swap and then swings tail to it, and dequeue
+* swings head to the successor, which becomes the new dummy.
+* A thread that finds tail behind the last node moves it on
+* before going further, so no one waits on a stalled thread.
+* Nodes a dequeue unlinks go through epoch.c, which also
+* rules out ABA on head and tail: no node is reused while a
+* thread that read it may still compare against it.
+*
+* A batch enqueue links a whole private chain with one
+* compare and swap; a batch dequeue swings head over up to
+* max nodes at once.  The bound, when there is one, is a
+* counter that enqueues reserve room in before linking.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "concurrentQueue.h"
+#include "epoch.h"
+
+struct QueueNode {
+	TYPE                        value;
+	struct QueueNode *_Atomic   next;
+};
+
+/* head and tail on lines of their own, as producers and consumers each
+   hammer one of them */
+struct ConcurrentQueue {
+	_Alignas(64) struct QueueNode *_Atomic head;	/* the dummy */
+	_Alignas(64) struct QueueNode *_Atomic tail;	/* the last node, or close behind it */
+	_Alignas(64) atomic_int                size;	/* values held, kept with a capacity only */
+	int                                    capacity;	/* 0 for no bound */
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to allocate an unlinked node
+ */
+static struct QueueNode *_newNode(TYPE value)
+{
+    struct QueueNode *node = malloc(sizeof(struct QueueNode));
+    assert(node != 0);
+    node->value = value;
+    atomic_init(&node->next, 0);
+    return node;
+}
+
+/*
+ epoch callback that frees a dequeued node
+ */
+static void _freeNode(void *node, void *ctx)
+{
+    (void)ctx;
+    free(node);
+}
+
+/*
+ helper function to reserve room for values under the capacity
+ param:	queue	the queue
+		n		values to be added
+ post:	returns how many of them fit, that many are counted in size
+ */
+static int _reserve(struct ConcurrentQueue *queue, int n)
+{
+    if (queue->capacity == 0) {
+        return n;
+    }
+    int before = atomic_fetch_add(&queue->size, n);
+    int fit = queue->capacity - before;
+    fit = (fit < 0) ? 0 : (fit > n) ? n : fit;
+    //give back what did not fit
+    if (fit < n) {
+        atomic_fetch_sub(&queue->size, n - fit);
+    }
+    return fit;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to allocate and initialize an empty queue
+ param:	capacity	most values the queue holds, 0 for no bound
+ post:	the queue holds only its dummy node
+ */
+struct ConcurrentQueue *concurrentQueueCreate(int capacity)
+{
+    assert(capacity >= 0);
+    struct ConcurrentQueue *queue = aligned_alloc(64, sizeof(struct ConcurrentQueue));
+    assert(queue != 0);
+    struct QueueNode *dummy = _newNode((TYPE)0);
+    atomic_init(&queue->head, dummy);
+    atomic_init(&queue->tail, dummy);
+    atomic_init(&queue->size, 0);
+    queue->capacity = capacity;
+    return queue;
+}
+
+/*
+ function to deallocate a queue
+ param:	queue	the queue
+ pre:	no other thread is using the queue
+ post:	the nodes still linked and the queue are freed
+ */
+void concurrentQueueDestroy(struct ConcurrentQueue *queue)
+{
+    //nodes this thread dequeued may still be waiting on the epoch
+    epochSynchronize();
+    struct QueueNode *cur = atomic_load(&queue->head);
+    while (cur != 0) {
+        struct QueueNode *next = atomic_load(&cur->next);
+        free(cur);
+        cur = next;
+    }
+    free(queue);
+}
+
+/*
+ function to tell if the queue is empty
+ param:	queue	the queue
+ post:	returns 1 if the queue held no values at some point during the call
+ */
+int concurrentQueueIsEmpty(struct ConcurrentQueue *queue)
+{
+    epochEnter();
+    struct QueueNode *head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    int empty = atomic_load_explicit(&head->next, memory_order_acquire) == 0;
+    epochExit();
+    return empty;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to add values at the back of the queue
+ param:	queue	the queue
+		values	the values, in order
+		n		how many
+ post:	the values that fit under the capacity are added next to each
+		other; returns how many were
+ */
+int concurrentQueueEnqueueBatch(struct ConcurrentQueue *queue, const TYPE *values, int n)
+{
+    n = _reserve(queue, n);
+    if (n <= 0) {
+        return 0;
+    }
+    //the chain is private until it is linked, so plain stores will do
+    struct QueueNode *first = _newNode(values[0]);
+    struct QueueNode *last = first;
+    for (int i = 1; i < n; i++) {
+        struct QueueNode *node = _newNode(values[i]);
+        atomic_store_explicit(&last->next, node, memory_order_relaxed);
+        last = node;
+    }
+    epochEnter();
+    for (;;) {
+        struct QueueNode *tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        struct QueueNode *next = atomic_load_explicit(&tail->next, memory_order_acquire);
+        //tail is behind the last node: move it on and look again
+        if (next != 0) {
+            atomic_compare_exchange_weak(&queue->tail, &tail, next);
+            continue;
+        }
+        //the release publishes the values of the whole chain
+        if (atomic_compare_exchange_weak_explicit(&tail->next, &next, first,
+                                                  memory_order_release, memory_order_relaxed)) {
+            //if this fails another thread has already moved tail on
+            atomic_compare_exchange_strong(&queue->tail, &tail, last);
+            break;
+        }
+    }
+    epochExit();
+    return n;
+}
+
+/*
+ function to take values from the front of the queue
+ param:	queue	the queue
+		values	where the values go
+		max		most values to take
+ post:	returns how many values were taken, in order, into values
+ */
+int concurrentQueueDequeueBatch(struct ConcurrentQueue *queue, TYPE *values, int max)
+{
+    struct QueueNode *head;
+    int taken;
+    epochEnter();
+    for (;;) {
+        head = atomic_load_explicit(&queue->head, memory_order_acquire);
+        struct QueueNode *tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+        //walk up to max nodes past the dummy; the last one becomes the dummy
+        struct QueueNode *last = head;
+        int passesTail = 0;
+        taken = 0;
+        while (taken < max) {
+            struct QueueNode *next = atomic_load_explicit(&last->next, memory_order_acquire);
+            if (next == 0) {
+                break;
+            }
+            passesTail |= (last == tail);
+            last = next;
+            taken++;
+        }
+        //the dummy had no successor, so the queue was empty when it was read
+        if (taken == 0) {
+            epochExit();
+            return 0;
+        }
+        //head must not pass tail, move tail on first
+        if (passesTail) {
+            atomic_compare_exchange_weak(&queue->tail, &tail, last);
+            continue;
+        }
+        if (atomic_compare_exchange_weak(&queue->head, &head, last)) {
+            break;
+        }
+    }
+    //the nodes taken are ours now, no other dequeue can reach them
+    struct QueueNode *cur = head;
+    for (int i = 0; i < taken; i++) {
+        cur = atomic_load_explicit(&cur->next, memory_order_relaxed);
+        values[i] = cur->value;
+    }
+    epochExit();
+    //the old dummy and every node taken but the new dummy can go
+    cur = head;
+    for (int i = 0; i < taken; i++) {
+        struct QueueNode *next = atomic_load_explicit(&cur->next, memory_order_relaxed);
+        epochRetire(cur, _freeNode, 0);
+        cur = next;
+    }
+    if (queue->capacity != 0) {
+        atomic_fetch_sub(&queue->size, taken);
+    }
+    return taken;
+}
+
+/*
+ function to add a value at the back of the queue
+ param:	queue	the queue
+		value	the value
+ post:	returns 1, or 0 if the queue was at capacity
+ */
+int concurrentQueueTryEnqueue(struct ConcurrentQueue *queue, TYPE value)
+{
+    return concurrentQueueEnqueueBatch(queue, &value, 1);
+}
+
+/*
+ function to take the value at the front of the queue
+ param:	queue	the queue
+		value	where the value goes
+ post:	returns 1, or 0 if the queue was empty
+ */
+int concurrentQueueTryDequeue(struct ConcurrentQueue *queue, TYPE *value)
+{
+    return concurrentQueueDequeueBatch(queue, value, 1);
+}
@@ -0,0 +1,44 @@
+/*
+  File: concurrentQueue.h
+  Interface definition of a FIFO queue that any number of threads may
+  enqueue to and dequeue from at the same time, without locks.  It takes
+  the place of linkedListAddBack / linkedListFront / linkedListRemoveFront
+  behind a mutex when a list is used as a work queue between threads.
+  Link with epoch.c; every thread that dequeues must call epochThreadExit
+  before it exits.
+*/
+
+#ifndef __CONCURRENT_QUEUE_H
+#define __CONCURRENT_QUEUE_H
+
+# ifndef TYPE
+# define TYPE      int
+# endif
+
+struct ConcurrentQueue;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Alocate and initialize an empty queue that holds at most capacity
+ * values, or any number of them if capacity is 0. */
+struct ConcurrentQueue *concurrentQueueCreate(int capacity);
+
+/* Deallocate the queue and the values still in it.  No other thread may be
+ * using it. */
+void concurrentQueueDestroy(struct ConcurrentQueue *queue);
+
+/*-- Queue interface, safe to call from any thread --*/
+int  concurrentQueueIsEmpty(struct ConcurrentQueue *queue);
+
+/* Add value at the back: returns 1, or 0 if the queue is at capacity. */
+int  concurrentQueueTryEnqueue(struct ConcurrentQueue *queue, TYPE value);
+/* Take the value at the front into *value: returns 1, or 0 if empty. */
+int  concurrentQueueTryDequeue(struct ConcurrentQueue *queue, TYPE *value);
+
+/* Add values[0 .. n) at the back, in order and next to each other, with
+ * one atomic link; returns how many fit under the capacity. */
+int  concurrentQueueEnqueueBatch(struct ConcurrentQueue *queue, const TYPE *values, int n);
+/* Take up to max values from the front into values with one atomic step;
+ * returns how many were taken, 0 if the queue was empty. */
+int  concurrentQueueDequeueBatch(struct ConcurrentQueue *queue, TYPE *values, int max);
+
+# endif
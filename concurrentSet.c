@@ -0,0 +1,387 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: concurrentSet.c
+*
+* Solution description: Lazy skip list (Herlihy, Lev,
+* Luchangco and Shavit).  Searches take no locks at all.
+* add and remove search without locks too, then lock only
+* the predecessors they are about to change and validate
+* that those are still unmarked and still point where the
+* search saw them; if not they search again.  A removed node
+* is first marked (logically deleted) and then unlinked, and
+* freed through epoch.c once no search can still be on it.
+* The size is kept in per thread counter shards so writers
+* do not all hit one cache line.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "concurrentSet.h"
+#include "epoch.h"
+
+/* Levels are kept with probability 1/4 each, enough for 2^48 values. */
+# define MAX_LEVEL 24
+
+/* Number of counter shards, a power of two. */
+# define COUNTER_SHARDS 16
+
+struct SetNode {
+	TYPE                      val;
+	int                       key;
+	int                       topLevel;
+	atomic_int                marked;	/* logically removed */
+	atomic_int                fullyLinked;	/* linked at every level */
+	atomic_flag               lock;
+	struct SetNode *_Atomic   next[];	/* topLevel + 1 entries */
+};
+
+struct CounterShard {
+	_Alignas(64) atomic_long count;
+};
+
+struct ConcurrentSet {
+	struct SetNode      *head;
+	struct SetNode      *tail;
+	struct CounterShard  shards[COUNTER_SHARDS];
+};
+
+static _Thread_local unsigned int rngState = 0;
+static _Thread_local int shard = -1;
+static atomic_int nextShard = 0;
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to allocate a node with links for levels 0..topLevel
+ */
+static struct SetNode *_newNode(TYPE val, int key, int topLevel)
+{
+    struct SetNode *node = malloc(sizeof(struct SetNode) +
+                                  (topLevel + 1) * sizeof(struct SetNode *));
+    assert(node != 0);
+    node->val = val;
+    node->key = key;
+    node->topLevel = topLevel;
+    atomic_init(&node->marked, 0);
+    atomic_init(&node->fullyLinked, 0);
+    atomic_flag_clear(&node->lock);
+    for (int i = 0; i <= topLevel; i++) {
+        atomic_init(&node->next[i], 0);
+    }
+    return node;
+}
+
+/*
+ epoch callback that frees a removed node
+ */
+static void _freeNode(void *node, void *ctx)
+{
+    (void)ctx;
+    free(node);
+}
+
+static void _lock(struct SetNode *node)
+{
+    while (atomic_flag_test_and_set_explicit(&node->lock, memory_order_acquire)) {
+        sched_yield();
+    }
+}
+
+static void _unlock(struct SetNode *node)
+{
+    atomic_flag_clear_explicit(&node->lock, memory_order_release);
+}
+
+/*
+ helper function to pick the top level of a new node, 0 with
+ probability 3/4, 1 with 3/16 and so on
+ */
+static int _randomLevel(void)
+{
+    if (rngState == 0) {
+        rngState = (unsigned int)(size_t)&rngState | 1;
+    }
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    int level = 0;
+    unsigned int bits = rngState;
+    while ((bits & 3) == 0 && level < MAX_LEVEL - 1) {
+        level++;
+        bits >>= 2;
+    }
+    return level;
+}
+
+/*
+ helper function to add to the calling thread's counter shard
+ */
+static void _count(struct ConcurrentSet *set, long delta)
+{
+    if (shard < 0) {
+        shard = atomic_fetch_add(&nextShard, 1) % COUNTER_SHARDS;
+    }
+    atomic_fetch_add_explicit(&set->shards[shard].count, delta, memory_order_relaxed);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to create an empty set
+ post: head and tail sentinels link to each other at every level
+ */
+struct ConcurrentSet *newConcurrentSet()
+{
+    struct ConcurrentSet *set = malloc(sizeof(struct ConcurrentSet));
+    assert(set != 0);
+    set->head = _newNode(0, 0, MAX_LEVEL - 1);
+    set->tail = _newNode(0, 0, MAX_LEVEL - 1);
+    for (int i = 0; i < MAX_LEVEL; i++) {
+        atomic_init(&set->head->next[i], set->tail);
+    }
+    atomic_init(&set->head->fullyLinked, 1);
+    atomic_init(&set->tail->fullyLinked, 1);
+    for (int i = 0; i < COUNTER_SHARDS; i++) {
+        atomic_init(&set->shards[i].count, 0);
+    }
+    return set;
+}
+
+/*
+ function to deallocate a set
+ pre: no other thread is using set
+ post: every node and the set itself are freed
+ */
+void deleteConcurrentSet(struct ConcurrentSet *set)
+{
+    assert(set != 0);
+    //nodes removed earlier may still be waiting on the epoch
+    epochSynchronize();
+    struct SetNode *cur = set->head;
+    while (cur != 0) {
+        struct SetNode *next = atomic_load(&cur->next[0]);
+        free(cur);
+        cur = next;
+    }
+    free(set);
+}
+
+/*
+ function to get the number of values in the set
+ post: the sum of the shards; exact when no write is in flight
+ */
+int sizeConcurrentSet(struct ConcurrentSet *set)
+{
+    assert(set != 0);
+    long total = 0;
+    for (int i = 0; i < COUNTER_SHARDS; i++) {
+        total += atomic_load_explicit(&set->shards[i].count, memory_order_relaxed);
+    }
+    return (int)total;
+}
+
+int isEmptyConcurrentSet(struct ConcurrentSet *set)
+{
+    return sizeConcurrentSet(set) == 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to find, at every level, the last node before key and the
+ first node at or after it
+ param:	set		the set
+		key		the key to search for
+		preds	receives the predecessor at each level
+		succs	receives the successor at each level
+ pre:	the calling thread is inside epochEnter
+ post:	returns the highest level at which a node with key was found, or -1
+ */
+static int _find(struct ConcurrentSet *set, int key,
+                 struct SetNode **preds, struct SetNode **succs)
+{
+    int found = -1;
+    struct SetNode *pred = set->head;
+    for (int level = MAX_LEVEL - 1; level >= 0; level--) {
+        struct SetNode *cur = atomic_load_explicit(&pred->next[level], memory_order_acquire);
+        while (cur != set->tail && cur->key < key) {
+            pred = cur;
+            cur = atomic_load_explicit(&pred->next[level], memory_order_acquire);
+        }
+        if (found == -1 && cur != set->tail && cur->key == key) {
+            found = level;
+        }
+        preds[level] = pred;
+        succs[level] = cur;
+    }
+    return found;
+}
+
+/*
+ helper function to unlock the distinct predecessors locked for levels
+ 0..highest
+ */
+static void _unlockPreds(struct SetNode **preds, int highest)
+{
+    struct SetNode *prev = 0;
+    for (int level = 0; level <= highest; level++) {
+        if (preds[level] != prev) {
+            _unlock(preds[level]);
+            prev = preds[level];
+        }
+    }
+}
+
+/*
+ function to determine if the set holds a value with the same key as val
+ param:	set		the set
+		val		the value to search for
+ pre:	set and val are not null
+ post:	return 1 if found, else 0; takes no locks
+ */
+int containsConcurrentSet(struct ConcurrentSet *set, TYPE val)
+{
+    assert(set != 0 && val != 0);
+    struct SetNode *preds[MAX_LEVEL];
+    struct SetNode *succs[MAX_LEVEL];
+    epochEnter();
+    int level = _find(set, key_type(val), preds, succs);
+    int found = level != -1 &&
+                atomic_load(&succs[level]->fullyLinked) &&
+                !atomic_load(&succs[level]->marked);
+    epochExit();
+    return found;
+}
+
+/*
+ function to add a value to the set
+ param:	set		the set
+		val		the value to add
+ pre:	set and val are not null
+ post:	return 1 if val was added, 0 if a value with its key was present
+ */
+int addConcurrentSet(struct ConcurrentSet *set, TYPE val)
+{
+    assert(set != 0 && val != 0);
+    int key = key_type(val);
+    int topLevel = _randomLevel();
+    struct SetNode *preds[MAX_LEVEL];
+    struct SetNode *succs[MAX_LEVEL];
+    epochEnter();
+    for (;;) {
+        int level = _find(set, key, preds, succs);
+        if (level != -1) {
+            struct SetNode *found = succs[level];
+            //a live node with the key wins, once it is fully in place
+            if (!atomic_load(&found->marked)) {
+                while (!atomic_load(&found->fullyLinked)) {
+                    sched_yield();
+                }
+                epochExit();
+                return 0;
+            }
+            //it is being removed, search again
+            continue;
+        }
+        //lock the predecessors bottom up and check nothing moved
+        int highest = -1;
+        int valid = 1;
+        struct SetNode *prev = 0;
+        for (int l = 0; valid && l <= topLevel; l++) {
+            struct SetNode *pred = preds[l];
+            if (pred != prev) {
+                _lock(pred);
+                prev = pred;
+            }
+            highest = l;
+            valid = !atomic_load(&pred->marked) && !atomic_load(&succs[l]->marked) &&
+                    atomic_load(&pred->next[l]) == succs[l];
+        }
+        if (!valid) {
+            _unlockPreds(preds, highest);
+            continue;
+        }
+        struct SetNode *node = _newNode(val, key, topLevel);
+        for (int l = 0; l <= topLevel; l++) {
+            atomic_init(&node->next[l], succs[l]);
+        }
+        for (int l = 0; l <= topLevel; l++) {
+            atomic_store_explicit(&preds[l]->next[l], node, memory_order_release);
+        }
+        atomic_store(&node->fullyLinked, 1);
+        _unlockPreds(preds, highest);
+        epochExit();
+        _count(set, 1);
+        return 1;
+    }
+}
+
+/*
+ function to remove the value with the same key as val
+ param:	set		the set
+		val		the value to remove
+ pre:	set and val are not null
+ post:	return 1 if a value was removed, else 0
+ */
+int removeConcurrentSet(struct ConcurrentSet *set, TYPE val)
+{
+    assert(set != 0 && val != 0);
+    int key = key_type(val);
+    struct SetNode *victim = 0;
+    struct SetNode *preds[MAX_LEVEL];
+    struct SetNode *succs[MAX_LEVEL];
+    epochEnter();
+    for (;;) {
+        int level = _find(set, key, preds, succs);
+        if (victim == 0) {
+            //only a fully linked node found at its own top level can go
+            if (level == -1) {
+                epochExit();
+                return 0;
+            }
+            struct SetNode *found = succs[level];
+            if (!atomic_load(&found->fullyLinked) || found->topLevel != level ||
+                atomic_load(&found->marked)) {
+                epochExit();
+                return 0;
+            }
+            _lock(found);
+            if (atomic_load(&found->marked)) {
+                _unlock(found);
+                epochExit();
+                return 0;
+            }
+            //marking is the point where the value leaves the set
+            atomic_store(&found->marked, 1);
+            victim = found;
+        }
+        //lock the predecessors bottom up and check they still point at victim
+        int highest = -1;
+        int valid = 1;
+        struct SetNode *prev = 0;
+        for (int l = 0; valid && l <= victim->topLevel; l++) {
+            struct SetNode *pred = preds[l];
+            if (pred != prev) {
+                _lock(pred);
+                prev = pred;
+            }
+            highest = l;
+            valid = !atomic_load(&pred->marked) && atomic_load(&pred->next[l]) == victim;
+        }
+        if (!valid) {
+            _unlockPreds(preds, highest);
+            continue;
+        }
+        for (int l = victim->topLevel; l >= 0; l--) {
+            atomic_store_explicit(&preds[l]->next[l], atomic_load(&victim->next[l]),
+                                  memory_order_release);
+        }
+        _unlock(victim);
+        _unlockPreds(preds, highest);
+        epochExit();
+        epochRetire(victim, _freeNode, 0);
+        _count(set, -1);
+        return 1;
+    }
+}
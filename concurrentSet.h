@@ -0,0 +1,41 @@
+/*
+  File: concurrentSet.h
+  Interface definition of an ordered set that any number of threads may
+  add to, remove from and search at the same time.  It mirrors the bag
+  interface of bst.h, but holds at most one value per key and reports
+  whether add and remove changed anything.  Link with compare.c, epoch.c
+  and writer.c.
+  "bstBench linearize" checks the results of racing threads against a
+  set run one operation at a time.
+*/
+
+#ifndef __CONCURRENT_SET_H
+#define __CONCURRENT_SET_H
+
+# ifndef TYPE
+# define TYPE      void*
+# endif
+
+/* function used to get the integer key of TYPE values, define this in your
+   compare.c file (see key_type in bst.h) */
+int key_type(TYPE curval);
+
+struct ConcurrentSet;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Alocate and initialize an empty set. */
+struct ConcurrentSet *newConcurrentSet();
+
+/* Deallocate the set.  No other thread may be using it. */
+void deleteConcurrentSet(struct ConcurrentSet *set);
+
+/*-- Set interface, safe to call from any thread --*/
+int  isEmptyConcurrentSet(struct ConcurrentSet *set);
+int     sizeConcurrentSet(struct ConcurrentSet *set);
+
+/* Return 1 if val was added, 0 if a value with the same key was there. */
+int      addConcurrentSet(struct ConcurrentSet *set, TYPE val);
+int containsConcurrentSet(struct ConcurrentSet *set, TYPE val);
+/* Return 1 if a value with the same key was removed, else 0. */
+int   removeConcurrentSet(struct ConcurrentSet *set, TYPE val);
+# endif
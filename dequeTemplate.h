@@ -0,0 +1,135 @@
+/*
+  File: dequeTemplate.h
+  Code generating deque of T values, the array counterpart of
+  circularList.h.  DEFINE_DEQUE(name, T) writes out a circular array deque
+  whose functions are all static inline and start with name, so deques of
+  several element types can live in one program.  The array doubles when
+  it fills, so every operation is O(1) amortized and values sit next to
+  each other in memory instead of one link per value.
+
+  Example:
+	DEFINE_DEQUE(DoubleDeque, double)
+
+	struct DoubleDeque deque;
+	DoubleDequeInit(&deque);
+	DoubleDequeAddBack(&deque, 1.5);
+	double front = DoubleDequeFront(&deque);
+	DoubleDequeRemoveFront(&deque);
+	DoubleDequeClear(&deque);
+
+  The generated functions are:
+	void nameInit(struct name *deque);
+	void nameClear(struct name *deque);
+	int  nameIsEmpty(struct name *deque);
+	int  nameSize(struct name *deque);
+	void nameAddFront(struct name *deque, T value);
+	void nameAddBack(struct name *deque, T value);
+	T    nameFront(struct name *deque);
+	T    nameBack(struct name *deque);
+	void nameRemoveFront(struct name *deque);
+	void nameRemoveBack(struct name *deque);
+  Front, Back and the removes require a deque that is not empty.
+*/
+
+#ifndef __DEQUE_TEMPLATE_H
+#define __DEQUE_TEMPLATE_H
+
+#include <stdlib.h>
+#include <assert.h>
+
+#define DEQUE_INITIAL_CAPACITY 8
+
+#define DEFINE_DEQUE(name, T)						\
+									\
+/* values live in data[(start + i) & (cap - 1)], cap a power of two */	\
+struct name {								\
+	T   *data;							\
+	int  cap;							\
+	int  start;							\
+	int  size;							\
+};									\
+									\
+static inline void name##Init(struct name *deque)			\
+{									\
+	deque->data = 0;						\
+	deque->cap = 0;							\
+	deque->start = 0;						\
+	deque->size = 0;						\
+}									\
+									\
+static inline void name##Clear(struct name *deque)			\
+{									\
+	free(deque->data);						\
+	name##Init(deque);						\
+}									\
+									\
+static inline int name##IsEmpty(struct name *deque)			\
+{									\
+	return deque->size == 0;					\
+}									\
+									\
+static inline int name##Size(struct name *deque)			\
+{									\
+	return deque->size;						\
+}									\
+									\
+/* double the array, unwrapping the values to start at index 0 */	\
+static inline void name##_grow(struct name *deque)			\
+{									\
+	int cap = deque->cap ? 2 * deque->cap : DEQUE_INITIAL_CAPACITY;	\
+	T *data = malloc(cap * sizeof(T));				\
+	assert(data != 0);						\
+	for (int i = 0; i < deque->size; i++) {				\
+		data[i] = deque->data[(deque->start + i) & (deque->cap - 1)]; \
+	}								\
+	free(deque->data);						\
+	deque->data = data;						\
+	deque->cap = cap;						\
+	deque->start = 0;						\
+}									\
+									\
+static inline void name##AddFront(struct name *deque, T value)		\
+{									\
+	if (deque->size == deque->cap) {				\
+		name##_grow(deque);					\
+	}								\
+	deque->start = (deque->start - 1) & (deque->cap - 1);		\
+	deque->data[deque->start] = value;				\
+	deque->size++;							\
+}									\
+									\
+static inline void name##AddBack(struct name *deque, T value)		\
+{									\
+	if (deque->size == deque->cap) {				\
+		name##_grow(deque);					\
+	}								\
+	deque->data[(deque->start + deque->size) & (deque->cap - 1)] = value; \
+	deque->size++;							\
+}									\
+									\
+static inline T name##Front(struct name *deque)				\
+{									\
+	assert(deque->size > 0);					\
+	return deque->data[deque->start];				\
+}									\
+									\
+static inline T name##Back(struct name *deque)				\
+{									\
+	assert(deque->size > 0);					\
+	return deque->data[(deque->start + deque->size - 1) & (deque->cap - 1)]; \
+}									\
+									\
+static inline void name##RemoveFront(struct name *deque)		\
+{									\
+	assert(deque->size > 0);					\
+	deque->start = (deque->start + 1) & (deque->cap - 1);		\
+	deque->size--;							\
+}									\
+									\
+static inline void name##RemoveBack(struct name *deque)			\
+{									\
+	assert(deque->size > 0);					\
+	deque->size--;							\
+}
+
+# endif
@@ -0,0 +1,223 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: epoch.c
+*
+* Solution description: Epoch based reclamation.  There is
+* one global epoch counter.  Each thread owns a record that
+* says whether it is inside a read and which epoch it saw
+* when it went in.  The global epoch only moves from e to
+* e+1 once every active reader has seen e, so anything
+* retired while the epoch was e is unreachable for all
+* readers once the epoch reaches e+2.
+* Retired items stay in a per thread list in epoch order and
+* are only ever released by the thread that retired them.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "epoch.h"
+
+struct Retired {
+	void          *ptr;
+	void         (*fn)(void *ptr, void *ctx);
+	void          *ctx;
+	unsigned long  epoch;
+};
+
+struct EpochRecord {
+	/* (epoch << 1) | 1 while inside a read, 0 outside */
+	atomic_ulong        state;
+	atomic_int          inUse;
+	struct EpochRecord *next;
+	/* owner thread only */
+	int                 nest;
+	struct Retired     *retired;
+	int                 count;
+	int                 cap;
+};
+
+static atomic_ulong globalEpoch = 1;
+static struct EpochRecord *_Atomic records = 0;
+static _Thread_local struct EpochRecord *self = 0;
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to get the calling thread's record, claiming a free one
+ or adding a new one to the list on first use
+ */
+static struct EpochRecord *_self(void)
+{
+    if (self != 0) {
+        return self;
+    }
+    //reuse a record a finished thread gave back
+    struct EpochRecord *rec;
+    for (rec = atomic_load(&records); rec != 0; rec = rec->next) {
+        int expected = 0;
+        if (atomic_load(&rec->inUse) == 0 &&
+            atomic_compare_exchange_strong(&rec->inUse, &expected, 1)) {
+            self = rec;
+            return rec;
+        }
+    }
+    //otherwise push a new one, records are never removed from the list
+    rec = calloc(1, sizeof(struct EpochRecord));
+    assert(rec != 0);
+    atomic_init(&rec->state, 0);
+    atomic_init(&rec->inUse, 1);
+    struct EpochRecord *head = atomic_load(&records);
+    do {
+        rec->next = head;
+    } while (!atomic_compare_exchange_weak(&records, &head, rec));
+    self = rec;
+    return rec;
+}
+
+/*
+ function to start a read side critical section
+ post:	memory retired from now on is not reclaimed until epochExit
+ */
+void epochEnter(void)
+{
+    struct EpochRecord *rec = _self();
+    if (rec->nest++ == 0) {
+        //publish the epoch we entered in before touching shared data
+        atomic_store(&rec->state, (atomic_load(&globalEpoch) << 1) | 1);
+    }
+}
+
+/*
+ function to end a read side critical section
+ pre:	matches an earlier epochEnter on this thread
+ */
+void epochExit(void)
+{
+    struct EpochRecord *rec = self;
+    assert(rec != 0 && rec->nest > 0);
+    if (--rec->nest == 0) {
+        atomic_store_explicit(&rec->state, 0, memory_order_release);
+    }
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to move the global epoch on by one if every active
+ reader has already seen the current epoch
+ post:	returns the global epoch afterwards
+ */
+static unsigned long _tryAdvance(void)
+{
+    unsigned long epoch = atomic_load(&globalEpoch);
+    struct EpochRecord *rec;
+    for (rec = atomic_load(&records); rec != 0; rec = rec->next) {
+        unsigned long state = atomic_load(&rec->state);
+        //a reader still in an older epoch holds everyone back
+        if ((state & 1) && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+    //losing the race just means someone else moved it on
+    atomic_compare_exchange_strong(&globalEpoch, &epoch, epoch + 1);
+    return atomic_load(&globalEpoch);
+}
+
+/*
+ helper function to release the retired items of a record that are at
+ least two epochs old
+ param:	rec		the calling thread's record
+		epoch	the current global epoch
+ */
+static void _release(struct EpochRecord *rec, unsigned long epoch)
+{
+    int done = 0;
+    //items are kept in epoch order so the old ones form a prefix
+    while (done < rec->count && rec->retired[done].epoch + 2 <= epoch) {
+        struct Retired *item = &rec->retired[done++];
+        item->fn(item->ptr, item->ctx);
+    }
+    if (done > 0) {
+        for (int i = done; i < rec->count; i++) {
+            rec->retired[i - done] = rec->retired[i];
+        }
+        rec->count -= done;
+    }
+}
+
+/*
+ function to retire memory that has been unlinked from a shared structure
+ param:	ptr		the memory
+		fn		called as fn(ptr, ctx) to release it
+		ctx		passed through to fn
+ pre:	no reader can find ptr anymore by starting a new search
+		the calling thread is not inside epochEnter
+ */
+void epochRetire(void *ptr, void (*fn)(void *ptr, void *ctx), void *ctx)
+{
+    struct EpochRecord *rec = _self();
+    assert(rec->nest == 0);
+    if (rec->count == rec->cap) {
+        rec->cap = (rec->cap == 0) ? EPOCH_BATCH : 2 * rec->cap;
+        rec->retired = realloc(rec->retired, rec->cap * sizeof(struct Retired));
+        assert(rec->retired != 0);
+    }
+    struct Retired *item = &rec->retired[rec->count++];
+    item->ptr = ptr;
+    item->fn = fn;
+    item->ctx = ctx;
+    item->epoch = atomic_load(&globalEpoch);
+    if (rec->count % EPOCH_BATCH == 0) {
+        epochReclaim();
+    }
+}
+
+/*
+ function to reclaim what the calling thread retired, as far as readers
+ allow right now
+ */
+void epochReclaim(void)
+{
+    struct EpochRecord *rec = _self();
+    _release(rec, _tryAdvance());
+}
+
+/*
+ function to wait for a grace period
+ pre:	the calling thread is not inside epochEnter
+ post:	readers active at the call have left and everything the calling
+		thread retired so far has been released
+ */
+void epochSynchronize(void)
+{
+    struct EpochRecord *rec = _self();
+    assert(rec->nest == 0);
+    unsigned long target = atomic_load(&globalEpoch) + 2;
+    while (_tryAdvance() < target) {
+        sched_yield();
+    }
+    _release(rec, atomic_load(&globalEpoch));
+}
+
+/*
+ function to detach the calling thread from epoch reclamation
+ pre:	the calling thread is not inside epochEnter
+ post:	the thread's retired items are released and its record is free
+ */
+void epochThreadExit(void)
+{
+    struct EpochRecord *rec = self;
+    if (rec == 0) {
+        return;
+    }
+    if (rec->count > 0) {
+        epochSynchronize();
+    }
+    free(rec->retired);
+    rec->retired = 0;
+    rec->cap = 0;
+    self = 0;
+    atomic_store(&rec->inUse, 0);
+}
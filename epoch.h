@@ -0,0 +1,37 @@
+/*
+  File: epoch.h
+  Interface definition of epoch based memory reclamation.  Threads that
+  read a shared structure without locks bracket each read with
+  epochEnter()/epochExit(); writers hand unlinked memory to epochRetire()
+  instead of freeing it, and it is released once every reader that could
+  still see it has left.
+*/
+
+#ifndef __EPOCH_H
+#define __EPOCH_H
+
+/* Retired items a thread collects before it tries to reclaim. */
+# ifndef EPOCH_BATCH
+# define EPOCH_BATCH 128
+# endif
+
+/* Start/end a read side critical section.  Calls may nest. */
+void epochEnter(void);
+void epochExit(void);
+
+/* Hand ptr over for reclamation: fn(ptr, ctx) is called by this thread
+ * once no reader can still hold ptr.  Must not be inside epochEnter. */
+void epochRetire(void *ptr, void (*fn)(void *ptr, void *ctx), void *ctx);
+
+/* Try to move the epoch on and reclaim what this thread has retired. */
+void epochReclaim(void);
+
+/* Wait until every reader that was active when called has left, then
+ * reclaim everything this thread has retired. */
+void epochSynchronize(void);
+
+/* Reclaim everything this thread retired and give its slot back.  Call
+ * before a thread that used any of the functions above exits. */
+void epochThreadExit(void);
+
+# endif
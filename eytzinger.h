@@ -0,0 +1,62 @@
+/*
+  File: eytzinger.h
+  Eytzinger (breadth first) layout of a sorted int array, shared by
+  frozenTree.c and mappedTree.c.  The root sits at index 1 and the
+  children of index k at 2k and 2k+1, index 0 is unused.  A search walks
+  down with a branchless step per level and prefetches the cache line
+  holding the node four levels further down, so keys should start on a
+  cache line.
+*/
+
+#ifndef __EYTZINGER_H
+#define __EYTZINGER_H
+
+#include <stddef.h>
+
+# ifdef __GNUC__
+# define EYTZINGER_PREFETCH(addr) __builtin_prefetch(addr)
+# define EYTZINGER_FFS(x)         __builtin_ffs(x)
+# else
+# include <strings.h>
+# define EYTZINGER_PREFETCH(addr) ((void)0)
+# define EYTZINGER_FFS(x)         ffs(x)
+# endif
+
+/* 16 ints per 64 byte cache line, i.e. four levels of the tree */
+# define EYTZINGER_KEYS_PER_LINE 16
+
+static inline int _eytzingerLayout(int *order, int cnt, int i, int k)
+{
+	if (k <= cnt) {
+		//an in order walk of the implicit tree visits the sorted values in order
+		i = _eytzingerLayout(order, cnt, i, 2 * k);
+		order[k] = i++;
+		i = _eytzingerLayout(order, cnt, i, 2 * k + 1);
+	}
+	return i;
+}
+
+/* Fills order[1..cnt] with the sorted index that goes at each Eytzinger
+ * index; order has room for cnt + 1 ints. */
+static inline void eytzingerLayout(int *order, int cnt)
+{
+	order[0] = 0;
+	_eytzingerLayout(order, cnt, 0, 1);
+}
+
+/* Eytzinger index of the first of keys[1..cnt] that is not less than key,
+ * or 0 if every key is smaller. */
+static inline int eytzingerLowerBound(const int *keys, int cnt, int key)
+{
+	int k = 1;
+	while (k <= cnt) {
+		//the 16 descendants four levels down share one cache line
+		EYTZINGER_PREFETCH(keys + (size_t)k * EYTZINGER_KEYS_PER_LINE);
+		//go right when the key here is smaller, without a branch
+		k = 2 * k + (keys[k] < key);
+	}
+	//undo the trailing right turns plus the last left turn
+	return k >> EYTZINGER_FFS(~k);
+}
+
+# endif
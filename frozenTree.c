@@ -0,0 +1,115 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: frozenTree.c
+*
+* Solution description: Immutable snapshot of a Binary Search
+* Tree for read-mostly phases.  The values are stored in
+* Eytzinger order (see eytzinger.h).  The int keys sit in
+* their own cache line aligned array, so a lookup touches one
+* line per four levels.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "frozenTree.h"
+#include "eytzinger.h"
+
+struct FrozenTree {
+	int   cnt;
+	int  *keys;	/* keys[1..cnt] in Eytzinger order, cache line aligned */
+	TYPE *vals;	/* vals[k] is the value keys[k] came from */
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to build a frozen snapshot of a tree
+ param:	tree	the binary search tree
+ pre:	tree is not null
+ post:	the snapshot holds every value of tree
+ */
+struct FrozenTree *freezeBSTree(struct BSTree *tree)
+{
+    assert(tree != 0);
+    struct FrozenTree *frozen = malloc(sizeof(struct FrozenTree));
+    assert(frozen != 0);
+    //sized and copied in one read, a concurrent writer cannot overrun it
+    TYPE *sorted = toNewArrayBSTree(tree, &frozen->cnt);
+    assert(sorted != 0);
+
+    //aligned_alloc wants a whole number of cache lines
+    size_t slots = (size_t)frozen->cnt + 1;
+    size_t bytes = ((slots * sizeof(int) + 63) / 64) * 64;
+    frozen->keys = aligned_alloc(64, bytes);
+    frozen->vals = malloc(slots * sizeof(TYPE));
+    assert(frozen->keys != 0 && frozen->vals != 0);
+    frozen->keys[0] = 0;
+    frozen->vals[0] = 0;
+
+    int *order = malloc(slots * sizeof(int));
+    assert(order != 0);
+    eytzingerLayout(order, frozen->cnt);
+    for (int k = 1; k <= frozen->cnt; k++) {
+        frozen->keys[k] = key_type(sorted[order[k]]);
+        frozen->vals[k] = sorted[order[k]];
+    }
+    free(order);
+    free(sorted);
+    return frozen;
+}
+
+/*
+ function to deallocate a frozen snapshot
+ param:	frozen	the snapshot
+ pre:	frozen is not null
+ */
+void deleteFrozenTree(struct FrozenTree *frozen)
+{
+    assert(frozen != 0);
+    free(frozen->keys);
+    free(frozen->vals);
+    free(frozen);
+}
+
+/*
+ function to get the number of values in a snapshot
+ param:	frozen	the snapshot
+ pre:	frozen is not null
+ */
+int sizeFrozenTree(struct FrozenTree *frozen)
+{
+    assert(frozen != 0);
+    return frozen->cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to determine if a snapshot contains a value with the same key
+ param:	frozen	the snapshot
+		val		the value to search for
+ pre:	frozen is not null
+		val is not null
+ post:	return 1 if found, else return 0
+ */
+int containsFrozenTree(struct FrozenTree *frozen, TYPE val)
+{
+    assert(frozen != 0 && val != 0);
+    int key = key_type(val);
+    int k = eytzingerLowerBound(frozen->keys, frozen->cnt, key);
+    return k != 0 && frozen->keys[k] == key;
+}
+
+/*
+ function to find the smallest value whose key is not less than val's
+ param:	frozen	the snapshot
+		val		the value to search for
+ pre:	frozen is not null
+		val is not null
+ post:	returns that value, or 0 if every value is smaller
+ */
+TYPE lowerBoundFrozenTree(struct FrozenTree *frozen, TYPE val)
+{
+    assert(frozen != 0 && val != 0);
+    return frozen->vals[eytzingerLowerBound(frozen->keys, frozen->cnt, key_type(val))];
+}
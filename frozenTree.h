@@ -0,0 +1,30 @@
+/*
+  File: frozenTree.h
+  Interface definition of a read-only snapshot of a binary search tree.
+  The snapshot keeps the key_type() keys inline in one array laid
+  out in Eytzinger (breadth first) order so a search touches one cache
+  line per few levels instead of one node per level.
+*/
+
+#ifndef __FROZEN_TREE_H
+#define __FROZEN_TREE_H
+
+#include "bst.h"
+
+struct FrozenTree;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Allocate a snapshot holding the current contents of tree.  The tree is
+ * not modified and can be changed or deleted afterwards; the values
+ * themselves are shared, not copied. */
+struct FrozenTree *freezeBSTree(struct BSTree *tree);
+
+/* Deallocate the snapshot. */
+void deleteFrozenTree(struct FrozenTree *frozen);
+
+int   sizeFrozenTree(struct FrozenTree *frozen);
+int   containsFrozenTree(struct FrozenTree *frozen, TYPE val);
+/* Smallest value that does not compare less than val, or 0 if none. */
+TYPE  lowerBoundFrozenTree(struct FrozenTree *frozen, TYPE val);
+
+# endif
@@ -0,0 +1,212 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: linkPool.c
+*
+* Solution description: The slow paths of the link pool.  A
+* new slab is aligned to its own size and all of its links go
+* on the free list at once, so linkPoolAlloc only ever pops.
+* Slabs come from anonymous mappings that are trimmed to a
+* slab boundary, so alignment wastes no memory, and each slab
+* is unmapped on its own when it is freed.
+* Trimming frees slabs with no links in use, beyond those
+* that fit under the high water mark, after one walk of the
+* free list to drop their links; the next trim waits until
+* another highWater links have been freed, so its cost is
+* spread over the frees that led to it.
+************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include "linkPool.h"
+
+/* Links start after the slab header, rounded up to 16 bytes */
+# define SLAB_HEADER ((sizeof(struct PoolSlab) + 15) & ~(size_t)15)
+
+/*
+ function to start an empty pool
+ param: pool		the pool
+		linkSize	bytes per link, at least a pointer
+		highWater	free links kept before empty slabs are freed, 0 for
+					no limit
+ pre:	pool is not null
+ post:	the pool holds no slabs
+ */
+void linkPoolInit(struct LinkPool *pool, size_t linkSize, int highWater)
+{
+    assert(linkSize >= sizeof(void *) && SLAB_HEADER + linkSize <= LINK_POOL_SLAB);
+    //links hold pointers, keep every one of them aligned
+    pool->linkSize = (linkSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    pool->freeList = 0;
+    pool->slabs = 0;
+    pool->spare = 0;
+    pool->spareSlabs = 0;
+    pool->regionSlabs = 1;
+    pool->slabCount = 0;
+    pool->freeCount = 0;
+    pool->highWater = highWater;
+    pool->trimAt = (highWater > 0) ? highWater : INT_MAX;
+}
+
+/*
+ function to free every slab of a pool
+ param: pool	the pool
+ post:	every link handed out is invalid, the pool is empty and reusable
+ */
+void linkPoolDestroy(struct LinkPool *pool)
+{
+    //slabs are handed out going up through each region and chained newest
+    //first, so most sit right below the one before; unmap such runs at once
+    char *lo = pool->spare;
+    char *hi = pool->spare + (size_t)pool->spareSlabs * LINK_POOL_SLAB;
+    for (struct PoolSlab *slab = pool->slabs; slab != 0; ) {
+        struct PoolSlab *next = slab->next;
+        if ((char *)slab != lo - LINK_POOL_SLAB) {
+            if (hi > lo) {
+                munmap(lo, hi - lo);
+            }
+            hi = (char *)slab + LINK_POOL_SLAB;
+        }
+        lo = (char *)slab;
+        slab = next;
+    }
+    if (hi > lo) {
+        munmap(lo, hi - lo);
+    }
+    linkPoolInit(pool, pool->linkSize, pool->highWater);
+}
+
+/*
+ function to get the memory a pool holds
+ param: pool	the pool
+ post:	returns the bytes of the slabs handed out.  A slab is a whole
+		number of pages and nothing sits between slabs; the spare slabs of
+		the last region are never touched, so they take no memory yet.
+ */
+long linkPoolBytes(struct LinkPool *pool)
+{
+    return (long)pool->slabCount * LINK_POOL_SLAB;
+}
+
+/*
+ helper function to map a region of slabs aligned to the slab size
+ param: pool	the pool, with no spare slabs left
+ post:	pool->spare holds pool->regionSlabs fresh slabs, and the next
+		region will be twice as big, up to LINK_POOL_REGION
+ */
+static void _linkPoolMap(struct LinkPool *pool)
+{
+    size_t bytes = (size_t)pool->regionSlabs * LINK_POOL_SLAB;
+    //one slab more than needed, then the unaligned ends go back
+    char *base = mmap(0, bytes + LINK_POOL_SLAB, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(base != MAP_FAILED);
+    char *start = (char *)(((uintptr_t)base + LINK_POOL_SLAB - 1) & ~(uintptr_t)(LINK_POOL_SLAB - 1));
+    if (start > base) {
+        munmap(base, start - base);
+    }
+    if (start + bytes < base + bytes + LINK_POOL_SLAB) {
+        munmap(start + bytes, base + LINK_POOL_SLAB - start);
+    }
+    pool->spare = start;
+    pool->spareSlabs = pool->regionSlabs;
+    //small lists map little, big ones few times
+    if (pool->regionSlabs < LINK_POOL_REGION) {
+        pool->regionSlabs *= 2;
+    }
+}
+
+/*
+ function to add a slab to a pool whose free list is empty
+ param: pool	the pool
+ post:	every link of the new slab is on the free list, lowest address first
+ */
+void _linkPoolGrow(struct LinkPool *pool)
+{
+    //aligned to its size, so _linkPoolSlab finds it from any of its links
+    if (pool->spareSlabs == 0) {
+        _linkPoolMap(pool);
+    }
+    struct PoolSlab *slab = (struct PoolSlab *)pool->spare;
+    pool->spare += LINK_POOL_SLAB;
+    pool->spareSlabs--;
+    slab->live = 0;
+    slab->prev = 0;
+    slab->next = pool->slabs;
+    if (pool->slabs != 0) {
+        pool->slabs->prev = slab;
+    }
+    pool->slabs = slab;
+    pool->slabCount++;
+    //pushed from the top down, so links come out in address order
+    int n = (int)((LINK_POOL_SLAB - SLAB_HEADER) / pool->linkSize);
+    char *first = (char *)slab + SLAB_HEADER;
+    for (int i = n - 1; i >= 0; i--) {
+        void *link = first + i * pool->linkSize;
+        *(void **)link = pool->freeList;
+        pool->freeList = link;
+    }
+    pool->freeCount += n;
+}
+
+/*
+ function to free slabs with no links in use, once the free list has
+ grown past the high water mark
+ param: pool	the pool
+ post:	empty slabs are freed until at most highWater free links are left,
+		or none are empty
+ */
+void _linkPoolTrim(struct LinkPool *pool)
+{
+    int perSlab = (int)((LINK_POOL_SLAB - SLAB_HEADER) / pool->linkSize);
+    int empty = 0;
+    for (struct PoolSlab *slab = pool->slabs; slab != 0; slab = slab->next) {
+        empty += (slab->live == 0);
+    }
+    //keep as many empty slabs as fit under the mark, mark the rest -1
+    int kept = pool->freeCount - empty * perSlab;
+    for (struct PoolSlab *slab = pool->slabs; slab != 0; slab = slab->next) {
+        if (slab->live == 0) {
+            if (kept + perSlab <= pool->highWater)
+                kept += perSlab;
+            else
+                slab->live = -1;
+        }
+    }
+    //what is left may be spread over slabs in use; wait for as many
+    //frees again before looking another time
+    pool->trimAt = (kept > INT_MAX - pool->highWater) ? INT_MAX : kept + pool->highWater;
+    if (kept == pool->freeCount) {
+        return;
+    }
+    //unhook the links of the marked slabs from the free list
+    void **prev = &pool->freeList;
+    while (*prev != 0) {
+        void *link = *prev;
+        if (_linkPoolSlab(link)->live < 0)
+            *prev = *(void **)link;
+        else
+            prev = (void **)link;
+    }
+    pool->freeCount = kept;
+    //then the marked slabs themselves can go, each unmapped on its own
+    struct PoolSlab *slab = pool->slabs;
+    while (slab != 0) {
+        struct PoolSlab *next = slab->next;
+        if (slab->live < 0) {
+            if (slab->prev != 0)
+                slab->prev->next = next;
+            else
+                pool->slabs = next;
+            if (next != 0)
+                next->prev = slab->prev;
+            munmap(slab, LINK_POOL_SLAB);
+            pool->slabCount--;
+        }
+        slab = next;
+    }
+}
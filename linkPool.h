@@ -0,0 +1,97 @@
+/*
+  File: linkPool.h
+  Slab allocator for the links of linkedList.c and circularList.c.  Links
+  are carved out of LINK_POOL_SLAB byte slabs and a freed link goes on an
+  intrusive free list, so a push or pop in steady state costs a couple of
+  pointer moves instead of a malloc and a free.  A list owns its pool and
+  destroying the pool unmaps whole slabs.
+
+  Slabs are aligned to their size, so the slab of a link is found by
+  masking its address.  They are cut from regions mapped straight from the
+  system, a few slabs at first and up to LINK_POOL_REGION at a time, as
+  malloc would leave a gap of about a slab next to each aligned slab.  Each
+  slab counts its links in use; once more than highWater links are free
+  the pool gives fully free slabs back.
+*/
+
+#ifndef __LINK_POOL_H
+#define __LINK_POOL_H
+
+#include <stddef.h>
+
+/* Bytes per slab, a power of two and a whole number of pages. */
+# ifndef LINK_POOL_SLAB
+# define LINK_POOL_SLAB (1 << 14)
+# endif
+
+/* Most slabs mapped at once; the slabs of a region not handed out yet are
+ * address space only, their pages are first touched when they are. */
+# ifndef LINK_POOL_REGION
+# define LINK_POOL_REGION 64
+# endif
+
+/* Free links a list keeps before it gives empty slabs back; 0 keeps all. */
+# ifndef LINK_POOL_HIGH_WATER
+# define LINK_POOL_HIGH_WATER 4096
+# endif
+
+/* Header at the start of each slab, the links follow it. */
+struct PoolSlab {
+	struct PoolSlab *next;
+	struct PoolSlab *prev;
+	int              live;	/* links of this slab in use */
+};
+
+struct LinkPool {
+	void            *freeList;	/* free links, each holds the next at offset 0 */
+	struct PoolSlab *slabs;
+	size_t           linkSize;
+	char            *spare;		/* slabs mapped but not handed out yet */
+	int              spareSlabs;
+	int              regionSlabs;	/* slabs in the next region mapped */
+	int              slabCount;
+	int              freeCount;
+	int              highWater;
+	int              trimAt;	/* freeCount that triggers the next trim */
+};
+
+/* Start an empty pool of links of linkSize bytes. */
+void linkPoolInit(struct LinkPool *pool, size_t linkSize, int highWater);
+/* Free every slab, and so every link, of the pool. */
+void linkPoolDestroy(struct LinkPool *pool);
+/* Memory held by the slabs handed out, every page of which is touched. */
+long linkPoolBytes(struct LinkPool *pool);
+
+/* Slow paths of the two below. */
+void _linkPoolGrow(struct LinkPool *pool);
+void _linkPoolTrim(struct LinkPool *pool);
+
+/* The slab a link was carved from. */
+static inline struct PoolSlab *_linkPoolSlab(void *link)
+{
+	return (struct PoolSlab *)((size_t)link & ~(size_t)(LINK_POOL_SLAB - 1));
+}
+
+/* Returns an uninitialized link. */
+static inline void *linkPoolAlloc(struct LinkPool *pool)
+{
+	if (pool->freeList == 0)
+		_linkPoolGrow(pool);
+	void *link = pool->freeList;
+	pool->freeList = *(void **)link;
+	pool->freeCount--;
+	_linkPoolSlab(link)->live++;
+	return link;
+}
+
+/* Gives a link from linkPoolAlloc back to the pool. */
+static inline void linkPoolFree(struct LinkPool *pool, void *link)
+{
+	*(void **)link = pool->freeList;
+	pool->freeList = link;
+	_linkPoolSlab(link)->live--;
+	if (++pool->freeCount > pool->trimAt)
+		_linkPoolTrim(pool);
+}
+
+# endif
@@ -22,17 +22,26 @@
 *
 *	Note that both implementations utilize a linked list with
 *	both a front and back sentinel and double links (links with
-*	next and prev pointers).
+*	next and prev pointers).  Links, sentinels included, come
+*	from a pool of slabs owned by the list (see linkPool.h).
 ************************************************************/
 #include "linkedList.h"
 #include <assert.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include "writer.h"
+#include "linkPool.h"
 
 #ifndef FORMAT_SPECIFIER
 #define FORMAT_SPECIFIER "%d"
 #endif
 
+// Writes one TYPE value for linkedListExport
+#ifndef WRITE_TYPE
+#define WRITE_TYPE(W, V) writeInt(W, V)
+#endif
+
 // Double link
 struct Link
 {
@@ -47,6 +56,10 @@ struct LinkedList
 	struct Link* frontSentinel;
 	struct Link* backSentinel;
 	int size;
+	struct LinkPool pool;	// slabs every link of this list comes from
+#ifdef COLLECT_STATS
+	struct Stats stats;
+#endif
 };
 
 /**
@@ -65,9 +78,10 @@ struct LinkedList
 static void init(struct LinkedList* list) {
     //list is not null
     assert(list != 0);
-    //allocate front and back sentinel links
-    list->frontSentinel = malloc(sizeof(struct Link));
-    list->backSentinel = malloc(sizeof(struct Link));
+    //allocate front and back sentinel links from the list's own pool
+    linkPoolInit(&list->pool, sizeof(struct Link), LINK_POOL_HIGH_WATER);
+    list->frontSentinel = linkPoolAlloc(&list->pool);
+    list->backSentinel = linkPoolAlloc(&list->pool);
     //front and back sentinel not null
     assert(list->frontSentinel != 0 && list->backSentinel != 0);
     //point frontSentinel next to back
@@ -80,6 +94,10 @@ static void init(struct LinkedList* list) {
     list->backSentinel->next = 0;
     //set list size to zero
     list->size = 0;
+#ifdef COLLECT_STATS
+    //start the counters at zero
+    memset(&list->stats, 0, sizeof(list->stats));
+#endif
 }
 
 /**
@@ -98,7 +116,7 @@ static void addLinkBefore(struct LinkedList* list, struct Link* link, TYPE value
     //list and link are not null
     assert(list != 0 && link != 0);
     //create new link to add to list
-    struct Link *new = malloc(sizeof(struct Link));
+    struct Link *new = linkPoolAlloc(&list->pool);
     //add value to new link
     new->value = value;
     //add new link before link passed as param
@@ -112,6 +130,8 @@ static void addLinkBefore(struct LinkedList* list, struct Link* link, TYPE value
     new->prev->next = new;
     //increment list size
     list->size++;
+    STAT_INC(list->stats.adds);
+    STAT_INC(list->stats.allocated);
 }
 
 /**
@@ -121,7 +141,7 @@ static void addLinkBefore(struct LinkedList* list, struct Link* link, TYPE value
  	param:	link 	struct Link ptr
 	pre: 	         list and link are not null
 	post: 	param link is removed from param list
-			memory allocated to link is freed
+			link is given back to the pool
 			list size is decremented by 1
  */
 static void removeLink(struct LinkedList* list, struct Link* link)
@@ -133,11 +153,13 @@ static void removeLink(struct LinkedList* list, struct Link* link)
     link->prev->next = link->next;
     //point link after param to point back to link prior to param
     link->next->prev = link->prev;
-    //memory allocated to link is freed
-    free(link);
+    //link is given back to the pool
+    linkPoolFree(&list->pool, link);
     link = 0;
     //list size is decremented by 1
     list->size--;
+    STAT_INC(list->stats.removes);
+    STAT_INC(list->stats.freed);
 }
 
 /**
@@ -159,18 +181,16 @@ struct LinkedList* linkedListCreate()
 	and frees the list itself.
 	param:	list 	struct LinkedList ptr
 	pre: 	         list is not null
-	post: 	memory allocated to each link is freed
+	post: 	memory allocated to each link is freed, a slab at a time
 			" " front and back sentinel " "
 			" " list " "
  */
 void linkedListDestroy(struct LinkedList* list)
 {
 	assert(list != NULL);
-	while (!linkedListIsEmpty(list)) {
-		linkedListRemoveFront(list);
-	}
-	free(list->frontSentinel);
-	free(list->backSentinel);
+	STAT_ADD(list->stats.freed, list->size);
+	//every link is in one of the pool's slabs
+	linkPoolDestroy(&list->pool);
 	free(list);
 	list = NULL;
 }
@@ -350,7 +370,9 @@ int linkedListContains(struct LinkedList* bag, TYPE value)
     //traverse bag and return if found
     //start at the beginning
     struct Link *placeHolder = bag->frontSentinel->next;
+    STAT_INC(bag->stats.lookups);
     while (placeHolder != bag->backSentinel) {
+        STAT_INC(bag->stats.compares);
         //return if found
         if (placeHolder->value == value)
             return 1;
@@ -377,7 +399,9 @@ void linkedListRemove(struct LinkedList* bag, TYPE value)
     //traverse bag and remove if found
     //start at the beginning
     struct Link *placeHolder = bag->frontSentinel->next;
+    STAT_INC(bag->stats.lookups);
     while (placeHolder != bag->backSentinel) {
+        STAT_INC(bag->stats.compares);
         //remove the link if the value is found and exit
         if (placeHolder->value == value) {
             removeLink(bag, placeHolder);
@@ -388,3 +412,111 @@ void linkedListRemove(struct LinkedList* bag, TYPE value)
             placeHolder = placeHolder->next;
     }
 }
+
+/**
+	Returns the number of links with the given value in the bag.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         none
+	ret:	         how many links hold the value
+ */
+int linkedListCount(struct LinkedList* bag, TYPE value)
+{
+    //bag is not null
+    assert(bag != 0);
+    int count = 0;
+    struct Link *placeHolder = bag->frontSentinel->next;
+    STAT_INC(bag->stats.lookups);
+    STAT_ADD(bag->stats.compares, bag->size);
+    while (placeHolder != bag->backSentinel) {
+        count += (placeHolder->value == value);
+        placeHolder = placeHolder->next;
+    }
+    return count;
+}
+
+/**
+	Removes every link with the given value from the bag.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         no link holds the value (call to removeLink)
+	ret:	         how many links were removed
+ */
+int linkedListRemoveAll(struct LinkedList* bag, TYPE value)
+{
+    //bag is not null
+    assert(bag != 0);
+    int removed = 0;
+    struct Link *placeHolder = bag->frontSentinel->next;
+    STAT_INC(bag->stats.lookups);
+    STAT_ADD(bag->stats.compares, bag->size);
+    while (placeHolder != bag->backSentinel) {
+        //step past the link before it is given back
+        struct Link *next = placeHolder->next;
+        if (placeHolder->value == value) {
+            removeLink(bag, placeHolder);
+            removed++;
+        }
+        placeHolder = next;
+    }
+    return removed;
+}
+
+/**
+	Writes the values of the links from front to back.
+	param:	list	struct LinkedList ptr
+	param:	w	struct Writer ptr, see writer.h
+	param:	format	EXPORT_TEXT or EXPORT_CSV for one value per line,
+			EXPORT_BINARY for the raw TYPE values
+	pre:	list and w are not null
+	post:	values are written through w (call to finishWriter to flush)
+	ret:	the number of values written
+ */
+int linkedListExport(struct LinkedList* list, struct Writer* w, int format)
+{
+    //list and w are not null
+    assert(list != 0 && w != 0);
+    struct Link *placeHolder = list->frontSentinel->next;
+    while (placeHolder != list->backSentinel) {
+        if (format == EXPORT_BINARY) {
+            writeBytes(w, &placeHolder->value, sizeof(TYPE));
+        }
+        //text and CSV are the same with one column
+        else {
+            WRITE_TYPE(w, placeHolder->value);
+            writeChar(w, '\n');
+        }
+        placeHolder = placeHolder->next;
+    }
+    return list->size;
+}
+
+/** Statistics */
+/**
+	Fills in the statistics of the list.
+	param:	list	struct LinkedList ptr
+	param:	stats	struct Stats ptr
+	pre:	         list and stats are not null
+	post:	         counters are copied if built with COLLECT_STATS,
+			otherwise 0; size, links and bytes are measured;
+			height and avgDepth are 0
+ */
+void linkedListGetStats(struct LinkedList* list, struct Stats* stats)
+{
+    //list and stats are not null
+    assert(list != 0 && stats != 0);
+#ifdef COLLECT_STATS
+    *stats = list->stats;
+#else
+    memset(stats, 0, sizeof(struct Stats));
+#endif
+    //every value has a link of its own
+    stats->size = list->size;
+    stats->nodes = list->size;
+    //the slabs holding the links and the list itself
+    stats->bytes = sizeof(struct LinkedList) + linkPoolBytes(&list->pool);
+    stats->height = 0;
+    stats->avgDepth = 0;
+}
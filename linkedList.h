@@ -1,6 +1,13 @@
 #ifndef LINKED_LIST_H
 #define LINKED_LIST_H
 
+// Two implementations, link with one of them and with writer.c:
+//   linkedList.c    one double link per value, links come from slabs
+//                   (link with linkPool.c too)
+//   unrolledList.c  values packed into cache line sized chunks, less
+//                   memory per value and array speed scans and push/pop;
+//                   int bags are scanned with SIMD (link with bagScan.c)
+
 #ifndef TYPE
 #define TYPE int
 #endif
@@ -13,6 +20,8 @@
 #define EQ(A, B) ((A) == (B))
 #endif
 
+#include "stats.h"
+
 struct LinkedList;
 
 struct LinkedList* linkedListCreate(void);
@@ -34,5 +43,18 @@ void linkedListRemoveBack(struct LinkedList* list);
 void linkedListAdd(struct LinkedList* list, TYPE value);
 int linkedListContains(struct LinkedList* list, TYPE value);
 void linkedListRemove(struct LinkedList* list, TYPE value);
+// Number of values equal to value
+int linkedListCount(struct LinkedList* list, TYPE value);
+// Removes every value equal to value and returns how many there were
+int linkedListRemoveAll(struct LinkedList* list, TYPE value);
+
+// Export, see writer.h for the formats
+
+struct Writer;
+int linkedListExport(struct LinkedList* list, struct Writer* w, int format);
+
+// Statistics, counters need -DCOLLECT_STATS (see stats.h)
+
+void linkedListGetStats(struct LinkedList* list, struct Stats* stats);
 
 #endif
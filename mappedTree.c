@@ -0,0 +1,350 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: mappedTree.c
+*
+* Solution description: Saves a Binary Search Tree of struct
+* data values to a file that can be mapped and searched
+* without loading it.  The file is a header followed by three
+* sections: the int keys in Eytzinger order (see
+* eytzinger.h), a record per key with the number and the
+* offset of its name, and the NUL terminated names.  Nothing
+* in the file is a pointer, so it works wherever it is mapped.
+************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mappedTree.h"
+#include "structs.h"
+#include "eytzinger.h"
+
+# define MAPPED_MAGIC   "BSTMAP\r\n"
+# define MAPPED_VERSION 1
+/* written as a number, reads back differently on the other byte order */
+# define MAPPED_ORDER   0x01020304u
+/* name offset of a record without a name */
+# define NO_NAME        UINT32_MAX
+
+/* The first 64 bytes of the file.  Section offsets count from the start of
+ * the file and are multiples of 64, so the keys start on a cache line. */
+struct FileHeader {
+	char     magic[8];
+	uint32_t version;
+	uint32_t order;
+	uint32_t cnt;
+	uint32_t intSize;	/* sizeof(int) of the writer, the keys are ints */
+	uint64_t keys;		/* int keys[cnt + 1], keys[1..cnt] in Eytzinger order */
+	uint64_t records;	/* struct FileRecord records[cnt + 1], parallel to keys */
+	uint64_t strings;	/* names, each NUL terminated */
+	uint64_t stringBytes;
+	uint64_t fileBytes;
+};
+
+struct FileRecord {
+	int32_t  number;
+	uint32_t name;		/* offset in the string section, or NO_NAME */
+};
+
+struct MappedTree {
+	void                    *base;
+	size_t                   bytes;
+	int                      cnt;
+	const int               *keys;
+	const struct FileRecord *records;
+	const char              *strings;
+	uint64_t                 stringBytes;
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to round a file offset up to a whole cache line
+ */
+static uint64_t _alignLine(uint64_t offset)
+{
+    return (offset + 63) & ~(uint64_t)63;
+}
+
+/*
+ helper function to write zeros up to the next cache line
+ param:	file	the output file
+		offset	the current offset in the file
+ post:	returns the new offset
+ */
+static uint64_t _pad(FILE *file, uint64_t offset)
+{
+    static const char zeros[64];
+    uint64_t next = _alignLine(offset);
+    fwrite(zeros, 1, next - offset, file);
+    return next;
+}
+
+/*
+ function to save a tree to a file that mapBSTree can open
+ param:	tree	the binary search tree, holding struct data values
+		path	the file to write, replaced if it exists
+ pre:	tree and path are not null
+ post:	returns 0 on success or -1 with errno set.  The file is written
+		under a temporary name and renamed, so a failed save leaves an
+		older file at path intact.
+ */
+int saveBSTree(struct BSTree *tree, const char *path)
+{
+    assert(tree != 0 && path != 0);
+    //sized and copied in one read, a concurrent writer cannot overrun it
+    int cnt;
+    TYPE *sorted = toNewArrayBSTree(tree, &cnt);
+    size_t slots = (size_t)cnt + 1;
+    int *order = malloc(slots * sizeof(int));
+    int *keys = calloc(slots, sizeof(int));
+    struct FileRecord *records = calloc(slots, sizeof(struct FileRecord));
+    char *tmp = malloc(strlen(path) + 5);
+    if (sorted == 0 || order == 0 || keys == 0 || records == 0 || tmp == 0) {
+        free(sorted); free(order); free(keys); free(records); free(tmp);
+        errno = ENOMEM;
+        return -1;
+    }
+    eytzingerLayout(order, cnt);
+
+    //the names are written in Eytzinger order too, so a lookup that finds a
+    //key near the top of the tree also finds its name near the others
+    uint64_t stringBytes = 0;
+    int result = 0;
+    for (int k = 1; k <= cnt; k++) {
+        struct data *val = sorted[order[k]];
+        keys[k] = key_type(val);
+        records[k].number = val->number;
+        records[k].name = NO_NAME;
+        if (val->name != 0) {
+            //offsets are 32 bits to keep the records small
+            if (stringBytes >= NO_NAME) {
+                result = -1;
+                errno = EFBIG;
+                break;
+            }
+            records[k].name = (uint32_t)stringBytes;
+            stringBytes += strlen(val->name) + 1;
+        }
+    }
+
+    struct FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAPPED_MAGIC, sizeof(header.magic));
+    header.version = MAPPED_VERSION;
+    header.order = MAPPED_ORDER;
+    header.cnt = (uint32_t)cnt;
+    header.intSize = sizeof(int);
+    header.keys = _alignLine(sizeof(header));
+    header.records = _alignLine(header.keys + slots * sizeof(int));
+    header.strings = _alignLine(header.records + slots * sizeof(struct FileRecord));
+    header.stringBytes = stringBytes;
+    header.fileBytes = header.strings + stringBytes;
+
+    strcpy(tmp, path);
+    strcat(tmp, ".tmp");
+    FILE *file = (result == 0) ? fopen(tmp, "wb") : 0;
+    if (file != 0) {
+        uint64_t offset = fwrite(&header, 1, sizeof(header), file);
+        offset = _pad(file, offset);
+        offset += fwrite(keys, sizeof(int), slots, file) * sizeof(int);
+        offset = _pad(file, offset);
+        offset += fwrite(records, sizeof(struct FileRecord), slots, file) * sizeof(struct FileRecord);
+        _pad(file, offset);
+        for (int k = 1; k <= cnt; k++) {
+            struct data *val = sorted[order[k]];
+            if (val->name != 0) {
+                fwrite(val->name, 1, strlen(val->name) + 1, file);
+            }
+        }
+        //fwrite errors are sticky, one check at the end covers them all
+        if (ferror(file)) {
+            result = -1;
+        }
+        if (fclose(file) != 0) {
+            result = -1;
+        }
+        if (result == 0 && rename(tmp, path) != 0) {
+            result = -1;
+        }
+        if (result != 0) {
+            int saved = errno;
+            remove(tmp);
+            errno = saved;
+        }
+    }
+    else {
+        result = -1;
+    }
+    free(sorted);
+    free(order);
+    free(keys);
+    free(records);
+    free(tmp);
+    return result;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to check that a header describes a file we can search
+ param:	header	the header at the start of the mapping
+		bytes	size of the mapping
+ post:	returns 1 if every section lies inside the mapping, else 0
+ */
+static int _validHeader(const struct FileHeader *header, size_t bytes)
+{
+    if (bytes < sizeof(*header)
+        || memcmp(header->magic, MAPPED_MAGIC, sizeof(header->magic)) != 0
+        || header->version != MAPPED_VERSION
+        || header->order != MAPPED_ORDER
+        || header->intSize != sizeof(int)
+        || header->cnt > INT32_MAX - 1
+        || header->fileBytes != bytes) {
+        return 0;
+    }
+    uint64_t slots = (uint64_t)header->cnt + 1;
+    //each section starts on a cache line and ends before the next one.  The
+    //offsets come from the file, so they are ordered inside it first and the
+    //sizes compared with their differences; adding to them could wrap
+    return (header->keys % 64) == 0 && (header->records % 64) == 0
+        && sizeof(*header) <= header->keys
+        && header->keys <= header->records
+        && header->records <= header->strings
+        && header->strings <= bytes
+        && slots * sizeof(int) <= header->records - header->keys
+        && slots * sizeof(struct FileRecord) <= header->strings - header->records
+        && header->stringBytes == bytes - header->strings
+        //the last name has to be terminated inside the file
+        && (header->stringBytes == 0 || ((const char *)header)[bytes - 1] == '\0');
+}
+
+/*
+ function to map a file written by saveBSTree
+ param:	path	the file to map
+ pre:	path is not null
+ post:	returns the mapped tree, or 0 with errno set.  The pages are read
+		in by the first searches that touch them, so this takes the same
+		time for any size of file.
+ */
+struct MappedTree *mapBSTree(const char *path)
+{
+    assert(path != 0);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return 0;
+    }
+    size_t bytes = (size_t)st.st_size;
+    void *base = (bytes >= sizeof(struct FileHeader))
+                 ? mmap(0, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    //the mapping stays valid after the descriptor is closed
+    close(fd);
+    if (base == MAP_FAILED || !_validHeader(base, bytes)) {
+        if (base != MAP_FAILED) {
+            munmap(base, bytes);
+        }
+        errno = EINVAL;
+        return 0;
+    }
+    struct MappedTree *mapped = malloc(sizeof(struct MappedTree));
+    if (mapped == 0) {
+        munmap(base, bytes);
+        errno = ENOMEM;
+        return 0;
+    }
+    const struct FileHeader *header = base;
+    mapped->base = base;
+    mapped->bytes = bytes;
+    mapped->cnt = (int)header->cnt;
+    mapped->keys = (const int *)((const char *)base + header->keys);
+    mapped->records = (const struct FileRecord *)((const char *)base + header->records);
+    mapped->strings = (const char *)base + header->strings;
+    mapped->stringBytes = header->stringBytes;
+    return mapped;
+}
+
+/*
+ function to unmap a file mapped with mapBSTree
+ param:	mapped	the mapped tree
+ pre:	mapped is not null
+ */
+void unmapBSTree(struct MappedTree *mapped)
+{
+    assert(mapped != 0);
+    munmap(mapped->base, mapped->bytes);
+    free(mapped);
+}
+
+/*
+ function to get the number of values in a mapped tree
+ param:	mapped	the mapped tree
+ pre:	mapped is not null
+ */
+int sizeMappedTree(struct MappedTree *mapped)
+{
+    assert(mapped != 0);
+    return mapped->cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to find the key equal to key
+ param:	mapped	the mapped tree
+		key		the key to search for
+ post:	returns the Eytzinger index of that key, or 0 if it is not there
+ */
+static int _find(struct MappedTree *mapped, int key)
+{
+    int k = eytzingerLowerBound(mapped->keys, mapped->cnt, key);
+    return (k != 0 && mapped->keys[k] == key) ? k : 0;
+}
+
+/*
+ function to determine if a mapped tree holds a value with the same key
+ param:	mapped	the mapped tree
+		val		the value to search for
+ pre:	mapped is not null
+		val is not null
+ post:	return 1 if found, else return 0
+ */
+int containsMappedTree(struct MappedTree *mapped, TYPE val)
+{
+    assert(mapped != 0 && val != 0);
+    return _find(mapped, key_type(val)) != 0;
+}
+
+/*
+ function to read the record with the same key as val
+ param:	mapped	the mapped tree
+		val		the value to search for
+		out		receives the record
+ pre:	mapped, val and out are not null
+ post:	return 1 and fill *out if found, else return 0
+ */
+int findMappedTree(struct MappedTree *mapped, TYPE val, struct data *out)
+{
+    assert(mapped != 0 && val != 0 && out != 0);
+    int k = _find(mapped, key_type(val));
+    if (k == 0) {
+        return 0;
+    }
+    const struct FileRecord *record = &mapped->records[k];
+    out->number = record->number;
+    //a damaged offset reads as no name rather than outside the mapping
+    out->name = (record->name < mapped->stringBytes)
+                ? (char *)mapped->strings + record->name : 0;
+    return 1;
+}
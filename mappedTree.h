@@ -0,0 +1,40 @@
+/*
+  File: mappedTree.h
+  Interface definition of an on-disk copy of a binary search tree of
+  struct data values.  saveBSTree writes one file holding the keys in
+  Eytzinger order, the records and the name strings, linked by offsets
+  relative to the start of the file.  mapBSTree maps that file read-only
+  and searches it in place, with no parsing and no allocation per value.
+
+  The file uses the byte order and int size of the machine that wrote it;
+  mapBSTree rejects a file from a machine that differs.
+*/
+
+#ifndef __MAPPED_TREE_H
+#define __MAPPED_TREE_H
+
+#include "bst.h"
+
+struct data;
+struct MappedTree;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Write the contents of tree, whose values must be struct data pointers,
+ * to path.  Returns 0 on success or -1 with errno set. */
+int  saveBSTree(struct BSTree *tree, const char *path);
+
+/* Map a file written by saveBSTree.  Returns 0 with errno set if the file
+ * cannot be opened or is not a tree file. */
+struct MappedTree *mapBSTree(const char *path);
+
+/* Unmap the file; names handed out by findMappedTree become invalid. */
+void unmapBSTree(struct MappedTree *mapped);
+
+int  sizeMappedTree(struct MappedTree *mapped);
+int  containsMappedTree(struct MappedTree *mapped, TYPE val);
+/* Returns 1 and fills *out with the record whose key matches val, else 0.
+ * out->name points into the read-only mapping, or is 0 if the record had
+ * no name. */
+int  findMappedTree(struct MappedTree *mapped, TYPE val, struct data *out);
+
+# endif
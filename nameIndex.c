@@ -0,0 +1,451 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: nameIndex.c
+*
+* Solution description: Secondary index on struct data names.
+* The names are interned in an arena of large chunks that never
+* move, and a compressed trie maps each distinct name to the
+* records that carry it.  An edge label is a run of bytes of an
+* interned name, so splitting an edge only moves a pointer and
+* the trie never copies a name.  A node keeps its children in an
+* array sorted by first byte, at most 256 entries, so picking a
+* child is a bounded search and a lookup is O(name length).
+************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "nameIndex.h"
+#include "structs.h"
+
+/* bytes per arena chunk; longer names get a chunk of their own */
+# define ARENA_CHUNK 65536
+
+struct ArenaChunk {
+	struct ArenaChunk *next;
+	size_t             used;
+	size_t             cap;
+	char               bytes[];
+};
+
+struct NameNode {
+	const char       *label;	/* bytes on the edge into this node */
+	int               len;
+	unsigned char    *first;	/* first byte of each child's label, sorted */
+	struct NameNode **kids;
+	int               nkids;
+	int               capKids;
+	char             *name;		/* interned name ending here, or 0 */
+	struct data     **recs;		/* records named name */
+	int               nrecs;
+	int               capRecs;
+};
+
+struct NameIndex {
+	struct NameNode    root;
+	struct ArenaChunk *arena;
+	int                cnt;
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to allocate and initialize an empty index
+ param: none
+ pre: none
+ post: the index has no names and no records
+ */
+struct NameIndex *newNameIndex()
+{
+    struct NameIndex *index = calloc(1, sizeof(struct NameIndex));
+    assert(index != 0);
+    return index;
+}
+
+/*
+ helper function to free a subtree of the trie
+ param: cur	the node, its edge is not freed
+ */
+void _freeNameNode(struct NameNode *cur)
+{
+    for (int i = 0; i < cur->nkids; i++) {
+        _freeNameNode(cur->kids[i]);
+        free(cur->kids[i]);
+    }
+    free(cur->first);
+    free(cur->kids);
+    free(cur->recs);
+}
+
+/*
+ function to deallocate the index
+ param: index	the index
+ pre: index is not null
+ post: the trie, the arena and the index are deallocated
+ */
+void deleteNameIndex(struct NameIndex *index)
+{
+    _freeNameNode(&index->root);
+    while (index->arena != 0) {
+        struct ArenaChunk *next = index->arena->next;
+        free(index->arena);
+        index->arena = next;
+    }
+    free(index);
+}
+
+/*
+ function to get the number of records in the index
+ param: index	the index
+ pre: index is not null
+ */
+int sizeNameIndex(struct NameIndex *index)
+{
+    return index->cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to copy a string into the arena
+ param: index	the index that owns the arena
+		name	the string
+		len		strlen(name)
+ post:	returns the copy, which stays put until the index is deleted
+ */
+char *_arenaCopy(struct NameIndex *index, const char *name, size_t len)
+{
+    struct ArenaChunk *chunk = index->arena;
+    if (chunk == 0 || chunk->cap - chunk->used < len + 1) {
+        size_t cap = (len + 1 > ARENA_CHUNK) ? len + 1 : ARENA_CHUNK;
+        chunk = malloc(sizeof(struct ArenaChunk) + cap);
+        assert(chunk != 0);
+        chunk->used = 0;
+        chunk->cap = cap;
+        //only the newest chunk takes new names, the rest are full enough
+        chunk->next = index->arena;
+        index->arena = chunk;
+    }
+    char *copy = chunk->bytes + chunk->used;
+    memcpy(copy, name, len + 1);
+    chunk->used += len + 1;
+    return copy;
+}
+
+/*
+ helper function to find the child of a node whose label starts with c
+ param: cur	the node
+		c	the byte
+ post:	returns the index of that child if there is one, otherwise
+		-(the index it would be inserted at) - 1
+ */
+int _findKid(struct NameNode *cur, unsigned char c)
+{
+    int lo = 0, hi = cur->nkids;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cur->first[mid] < c) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return (lo < cur->nkids && cur->first[lo] == c) ? lo : -lo - 1;
+}
+
+/*
+ helper function to put a child in a node's sorted child array
+ param: cur	the node
+		at	where it goes, from _findKid
+		kid	the child, its label is set
+ */
+void _insertKid(struct NameNode *cur, int at, struct NameNode *kid)
+{
+    if (cur->nkids == cur->capKids) {
+        cur->capKids = cur->capKids ? 2 * cur->capKids : 2;
+        cur->first = realloc(cur->first, cur->capKids);
+        cur->kids = realloc(cur->kids, cur->capKids * sizeof(struct NameNode *));
+        assert(cur->first != 0 && cur->kids != 0);
+    }
+    memmove(cur->first + at + 1, cur->first + at, cur->nkids - at);
+    memmove(cur->kids + at + 1, cur->kids + at,
+            (cur->nkids - at) * sizeof(struct NameNode *));
+    cur->first[at] = (unsigned char)kid->label[0];
+    cur->kids[at] = kid;
+    cur->nkids++;
+}
+
+/*
+ helper function to allocate a trie node
+ param: label	the bytes on the edge into the node
+		len		how many
+ */
+struct NameNode *_newNameNode(const char *label, int len)
+{
+    struct NameNode *new = calloc(1, sizeof(struct NameNode));
+    assert(new != 0);
+    new->label = label;
+    new->len = len;
+    return new;
+}
+
+/*
+ helper function to follow a string down the trie
+ param: index	the index
+		key		the string
+		partial	if not null, the walk may stop part way along an edge
+				whose remaining bytes start with the rest of key, and
+				*partial is set to 1 if it did
+ post:	returns the node key leads to, or null if it leads nowhere
+ */
+struct NameNode *_walk(struct NameIndex *index, const char *key, int *partial)
+{
+    struct NameNode *cur = &index->root;
+    size_t rest = strlen(key);
+    while (rest > 0) {
+        int at = _findKid(cur, (unsigned char)key[0]);
+        if (at < 0) {
+            return 0;
+        }
+        cur = cur->kids[at];
+        //a key that ends inside this edge only matches a prefix search
+        if (rest < (size_t)cur->len) {
+            if (partial == 0 || memcmp(cur->label, key, rest) != 0) {
+                return 0;
+            }
+            *partial = 1;
+            return cur;
+        }
+        if (memcmp(cur->label, key, cur->len) != 0) {
+            return 0;
+        }
+        key += cur->len;
+        rest -= cur->len;
+    }
+    return cur;
+}
+
+/*
+ function to intern a name
+ param: index	the index
+		name	the name
+ pre:	index and name are not null
+ post:	returns the one arena copy of name, which has a node in the trie
+ */
+char *internNameIndex(struct NameIndex *index, const char *name)
+{
+    assert(index != 0 && name != 0);
+    struct NameNode *found = _walk(index, name, 0);
+    if (found != 0 && found->name != 0) {
+        return found->name;
+    }
+    size_t len = strlen(name);
+    char *copy = _arenaCopy(index, name, len);
+    //labels of new edges point into the copy
+    struct NameNode *cur = &index->root;
+    const char *key = copy;
+    while (*key != '\0') {
+        int at = _findKid(cur, (unsigned char)key[0]);
+        //nothing starts with this byte: the rest of the name is one edge
+        if (at < 0) {
+            struct NameNode *leaf = _newNameNode(key, (int)strlen(key));
+            _insertKid(cur, -at - 1, leaf);
+            cur = leaf;
+            break;
+        }
+        struct NameNode *kid = cur->kids[at];
+        int same = 1;
+        while (same < kid->len && key[same] == kid->label[same]) {
+            same++;
+        }
+        //the edge matches part way: split it where the name leaves it
+        if (same < kid->len) {
+            struct NameNode *mid = _newNameNode(kid->label, same);
+            kid->label += same;
+            kid->len -= same;
+            mid->first = malloc(2);
+            mid->kids = malloc(2 * sizeof(struct NameNode *));
+            assert(mid->first != 0 && mid->kids != 0);
+            mid->capKids = 2;
+            mid->first[0] = (unsigned char)kid->label[0];
+            mid->kids[0] = kid;
+            mid->nkids = 1;
+            cur->kids[at] = mid;
+            kid = mid;
+        }
+        cur = kid;
+        key += same;
+    }
+    cur->name = copy;
+    return copy;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to add a record to the index
+ param: index	the index
+		rec		the record
+ pre:	index and rec are not null
+ post:	rec->name points at the interned copy and rec is indexed under it,
+		or nothing changes if rec has no name
+ */
+void addNameIndex(struct NameIndex *index, struct data *rec)
+{
+    assert(index != 0 && rec != 0);
+    if (rec->name == 0) {
+        return;
+    }
+    rec->name = internNameIndex(index, rec->name);
+    struct NameNode *cur = _walk(index, rec->name, 0);
+    if (cur->nrecs == cur->capRecs) {
+        cur->capRecs = cur->capRecs ? 2 * cur->capRecs : 1;
+        cur->recs = realloc(cur->recs, cur->capRecs * sizeof(struct data *));
+        assert(cur->recs != 0);
+    }
+    cur->recs[cur->nrecs++] = rec;
+    index->cnt++;
+}
+
+/*
+ function to remove a record from the index
+ param: index	the index
+		rec		the record
+ pre:	index and rec are not null
+ post:	rec is not in the index; the name stays interned
+ */
+void removeNameIndex(struct NameIndex *index, struct data *rec)
+{
+    assert(index != 0 && rec != 0);
+    if (rec->name == 0) {
+        return;
+    }
+    struct NameNode *cur = _walk(index, rec->name, 0);
+    if (cur == 0) {
+        return;
+    }
+    for (int i = 0; i < cur->nrecs; i++) {
+        if (cur->recs[i] == rec) {
+            //order among records of one name does not matter
+            cur->recs[i] = cur->recs[--cur->nrecs];
+            index->cnt--;
+            return;
+        }
+    }
+}
+
+/*
+ function to find the records with a given name
+ param: index	the index
+		name	the name
+		out		room for max records
+		max		how many records out can take
+ pre:	index and name are not null
+ post:	returns the number of records named name, the first max of them
+		are in out
+ */
+int findNameIndex(struct NameIndex *index, const char *name,
+                  struct data **out, int max)
+{
+    assert(index != 0 && name != 0);
+    struct NameNode *cur = _walk(index, name, 0);
+    if (cur == 0) {
+        return 0;
+    }
+    for (int i = 0; i < cur->nrecs && i < max; i++) {
+        out[i] = cur->recs[i];
+    }
+    return cur->nrecs;
+}
+
+/*
+ recursive helper function to visit the records of a subtree in order
+ param: cur	the root of the subtree
+		fn	called on each record
+		arg	passed to fn
+ post:	returns the number of records visited
+ */
+int _forEachName(struct NameNode *cur, void (*fn)(struct data *, void *), void *arg)
+{
+    int visited = cur->nrecs;
+    for (int i = 0; i < cur->nrecs; i++) {
+        fn(cur->recs[i], arg);
+    }
+    //children are sorted by first byte, so names come out in byte order
+    for (int i = 0; i < cur->nkids; i++) {
+        visited += _forEachName(cur->kids[i], fn, arg);
+    }
+    return visited;
+}
+
+/*
+ function to visit every record whose name starts with a prefix
+ param: index	the index
+		prefix	the prefix, "" matches every name
+		fn		called on each record
+		arg		passed to fn
+ pre:	index, prefix and fn are not null
+ post:	returns the number of records visited
+ */
+int forEachPrefixNameIndex(struct NameIndex *index, const char *prefix,
+                           void (*fn)(struct data *rec, void *arg), void *arg)
+{
+    assert(index != 0 && prefix != 0 && fn != 0);
+    int partial = 0;
+    struct NameNode *cur = _walk(index, prefix, &partial);
+    return (cur == 0) ? 0 : _forEachName(cur, fn, arg);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to index the records of a tree
+ param: index	the index
+		tree	a tree of struct data values
+ pre:	index and tree are not null
+ post:	every named record in tree is in the index
+ */
+void indexBSTree(struct NameIndex *index, struct BSTree *tree)
+{
+    struct BSTreeIter it;
+    TYPE val;
+    bstIterBegin(tree, &it);
+    while (bstIterNext(&it, &val)) {
+        addNameIndex(index, (struct data *)val);
+    }
+}
+
+/*
+ function to add a record to a tree and its index
+ param: tree	a tree of struct data values
+		index	the index of tree
+		rec		the record
+ pre:	tree, index and rec are not null
+ post:	rec is in both, with its name interned
+ */
+void addIndexedBSTree(struct BSTree *tree, struct NameIndex *index,
+                      struct data *rec)
+{
+    addNameIndex(index, rec);
+    addBSTree(tree, rec);
+}
+
+/*
+ function to remove a record from a tree and its index
+ param: tree	a tree of struct data values
+		index	the index of tree
+		rec		a record equal to the one to remove
+ pre:	tree, index and rec are not null
+		numbers in tree are distinct, or tree uses BST_MULTISET, so
+		removeBSTree takes out the same record found here
+ post:	the stored record equal to rec, if any, is in neither
+ */
+void removeIndexedBSTree(struct BSTree *tree, struct NameIndex *index,
+                         struct data *rec)
+{
+    struct data *stored = lowerBoundBSTree(tree, rec);
+    if (stored == 0 || compare(stored, rec) != 0) {
+        return;
+    }
+    removeNameIndex(index, stored);
+    removeBSTree(tree, stored);
+}
@@ -0,0 +1,62 @@
+/*
+  File: nameIndex.h
+  Interface definition of a secondary index on the name of struct data
+  records, kept next to a binary search tree ordered by number.  The
+  index is a compressed trie: each edge holds a run of name bytes and
+  each node branches on one byte, so an exact or prefix lookup costs
+  O(length of the name) no matter how many records are indexed.
+
+  Names are interned in a string arena owned by the index.  Every distinct
+  name is stored once, records point at that copy instead of a malloc'd
+  string of their own, and the copies live until the index is deleted.
+*/
+
+#ifndef __NAME_INDEX_H
+#define __NAME_INDEX_H
+
+#include "bst.h"
+
+struct data;
+struct NameIndex;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Allocate and initialize an empty index. */
+struct NameIndex *newNameIndex();
+
+/* Deallocate the index and its arena; every interned name becomes invalid. */
+void deleteNameIndex(struct NameIndex *index);
+
+/* Number of records in the index. */
+int   sizeNameIndex(struct NameIndex *index);
+
+/* Returns the arena copy of name, adding it the first time it is seen. */
+char *internNameIndex(struct NameIndex *index, const char *name);
+
+/* Index rec under its name, which is interned first: rec->name is pointed
+ * at the arena copy.  The string rec->name pointed to before is left to
+ * the caller.  Records without a name are not indexed. */
+void  addNameIndex(struct NameIndex *index, struct data *rec);
+/* Take rec itself (not another record with the same name) out of the index. */
+void  removeNameIndex(struct NameIndex *index, struct data *rec);
+
+/* Records named exactly name: returns how many there are and copies the
+ * first max of them into out. */
+int   findNameIndex(struct NameIndex *index, const char *name,
+                    struct data **out, int max);
+/* Calls fn on every record whose name starts with prefix, in byte order of
+ * the names, and returns how many there were. */
+int   forEachPrefixNameIndex(struct NameIndex *index, const char *prefix,
+                             void (*fn)(struct data *rec, void *arg), void *arg);
+
+/*-- Keeping a tree of struct data values and its index in step --*/
+/* Index every record already in tree. */
+void  indexBSTree(struct NameIndex *index, struct BSTree *tree);
+/* addBSTree and addNameIndex. */
+void  addIndexedBSTree(struct BSTree *tree, struct NameIndex *index,
+                       struct data *rec);
+/* removeBSTree of the stored record equal to rec, and removeNameIndex of
+ * that same record. */
+void  removeIndexedBSTree(struct BSTree *tree, struct NameIndex *index,
+                          struct data *rec);
+
+# endif
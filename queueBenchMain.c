@@ -0,0 +1,165 @@
+/* Producer/consumer timing driver for the queues.
+ *
+ * build: gcc -O2 -DNDEBUG -pthread -o queueBench queueBenchMain.c \
+ *        concurrentQueue.c epoch.c linkedList.c linkPool.c writer.c
+ * usage: ./queueBench [values per producer] [batch]
+ *
+ * For 1, 2, 4 ... up to twice the processor count producers, and as many
+ * consumers, every producer enqueues its values and the consumers dequeue
+ * until all of them are through, once with a LinkedList behind a mutex,
+ * once with single ConcurrentQueue operations and once with batches.
+ */
+#include "linkedList.h"
+#include "concurrentQueue.h"
+#include "epoch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sched.h>
+
+static double now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+enum mode { MUTEX_LIST, QUEUE_SINGLE, QUEUE_BATCH };
+
+struct shared {
+	enum mode               mode;
+	struct LinkedList      *list;
+	pthread_mutex_t         lock;
+	struct ConcurrentQueue *queue;
+	int                     perProducer;
+	int                     batch;
+	atomic_long             remaining;	/* values not yet dequeued */
+	atomic_long             checksum;
+};
+
+struct worker {
+	struct shared *s;
+	int            id;
+};
+
+static void *producer(void *arg)
+{
+	struct worker *w = arg;
+	struct shared *s = w->s;
+	int values[s->batch];
+	int base = w->id * s->perProducer;
+	for (int i = 0; i < s->perProducer; ) {
+		if (s->mode == MUTEX_LIST) {
+			pthread_mutex_lock(&s->lock);
+			linkedListAddBack(s->list, base + i);
+			pthread_mutex_unlock(&s->lock);
+			i++;
+		} else if (s->mode == QUEUE_SINGLE) {
+			if (concurrentQueueTryEnqueue(s->queue, base + i))
+				i++;
+			else
+				sched_yield();
+		} else {
+			int n = s->perProducer - i < s->batch ? s->perProducer - i : s->batch;
+			for (int j = 0; j < n; j++)
+				values[j] = base + i + j;
+			int added = concurrentQueueEnqueueBatch(s->queue, values, n);
+			if (added == 0)
+				sched_yield();
+			i += added;
+		}
+	}
+	epochThreadExit();
+	return 0;
+}
+
+static void *consumer(void *arg)
+{
+	struct worker *w = arg;
+	struct shared *s = w->s;
+	int values[s->batch];
+	long sum = 0;
+	while (atomic_load_explicit(&s->remaining, memory_order_relaxed) > 0) {
+		int got = 0;
+		if (s->mode == MUTEX_LIST) {
+			pthread_mutex_lock(&s->lock);
+			if (!linkedListIsEmpty(s->list)) {
+				values[0] = linkedListFront(s->list);
+				linkedListRemoveFront(s->list);
+				got = 1;
+			}
+			pthread_mutex_unlock(&s->lock);
+		} else if (s->mode == QUEUE_SINGLE) {
+			got = concurrentQueueTryDequeue(s->queue, &values[0]);
+		} else {
+			got = concurrentQueueDequeueBatch(s->queue, values, s->batch);
+		}
+		if (got == 0) {
+			sched_yield();	/* let a producer run, there may be fewer cores than threads */
+			continue;
+		}
+		for (int j = 0; j < got; j++)
+			sum += values[j];
+		atomic_fetch_sub_explicit(&s->remaining, got, memory_order_relaxed);
+	}
+	atomic_fetch_add(&s->checksum, sum);
+	epochThreadExit();
+	return 0;
+}
+
+static void run(enum mode mode, int threads, int perProducer, int batch)
+{
+	static const char *names[] = { "mutex LinkedList", "ConcurrentQueue", "ConcurrentQueue batch" };
+	struct shared s;
+	s.mode = mode;
+	s.list = (mode == MUTEX_LIST) ? linkedListCreate() : 0;
+	pthread_mutex_init(&s.lock, 0);
+	/* bounded, so producers cannot run away from slow consumers */
+	s.queue = (mode == MUTEX_LIST) ? 0 : concurrentQueueCreate(1 << 16);
+	s.perProducer = perProducer;
+	s.batch = (mode == QUEUE_BATCH) ? batch : 1;
+	long total = (long)threads * perProducer;
+	atomic_init(&s.remaining, total);
+	atomic_init(&s.checksum, 0);
+
+	struct worker workers[2 * threads];
+	pthread_t ids[2 * threads];
+	double t = now();
+	for (int i = 0; i < 2 * threads; i++) {
+		workers[i] = (struct worker){ &s, i % threads };
+		pthread_create(&ids[i], 0, i < threads ? producer : consumer, &workers[i]);
+	}
+	for (int i = 0; i < 2 * threads; i++)
+		pthread_join(ids[i], 0);
+	double secs = now() - t;
+
+	/* every value 0 .. total-1 came out exactly once if the sums agree */
+	long expect = total * (total - 1) / 2;
+	printf("%-22s producers=%-3d consumers=%-3d %8.1f ns/value %8.2f Mvalues/s%s\n",
+	       names[mode], threads, threads, secs * 1e9 / total, total / secs / 1e6,
+	       atomic_load(&s.checksum) == expect ? "" : "  CHECKSUM MISMATCH");
+	if (s.list)
+		linkedListDestroy(s.list);
+	if (s.queue)
+		concurrentQueueDestroy(s.queue);
+	pthread_mutex_destroy(&s.lock);
+}
+
+int main(int argc, char **argv)
+{
+	int perProducer = (argc > 1) ? atoi(argv[1]) : 1000000;
+	int batch = (argc > 2) ? atoi(argv[2]) : 32;
+	int cpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (perProducer <= 0 || batch <= 0) {
+		printf("usage: %s [values per producer] [batch]\n", argv[0]);
+		return 1;
+	}
+	for (int mode = MUTEX_LIST; mode <= QUEUE_BATCH; mode++)
+		for (int threads = 1; threads <= 2 * cpus; threads *= 2)
+			run(mode, threads, perProducer, batch);
+	epochThreadExit();
+	return 0;
+}
@@ -0,0 +1,282 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: splayTree.c
+*
+* Solution description: Implementation of a splay tree bag
+* ordered by compare().  Every operation starts with a top
+* down splay (Sleator and Tarjan): one walk from the root
+* that rotates the value looked for, or its neighbor, to the
+* root while taking the path apart into a left and a right
+* tree.  Nothing here recurses, since a splay tree can be a
+* long path after a run of sorted adds.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "splayTree.h"
+
+struct SplayNode {
+	TYPE              val;
+	struct SplayNode *left;
+	struct SplayNode *right;
+};
+
+struct SplayTree {
+	struct SplayNode *root;
+	int               cnt;
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to initialize the splay tree.
+ param: tree
+ pre: tree is not null
+ post:	tree size is 0
+		root is null
+ */
+void initSplayTree(struct SplayTree *tree)
+{
+    tree->cnt  = 0;
+    tree->root = 0;
+}
+
+/*
+ function to create a splay tree.
+ param: none
+ pre: none
+ post: tree->count = 0
+	tree->root = 0;
+ */
+struct SplayTree *newSplayTree()
+{
+    struct SplayTree *tree = malloc(sizeof(struct SplayTree));
+    assert(tree != 0);
+    initSplayTree(tree);
+    return tree;
+}
+
+/*
+ function to clear the nodes of a splay tree
+ param: tree    a splay tree
+ pre: tree is not null
+ post: the nodes of the tree are deallocated
+		root is NULL
+		tree size is 0
+ */
+void clearSplayTree(struct SplayTree *tree)
+{
+    struct SplayNode *cur = tree->root;
+    while (cur != 0) {
+        //rotate left children up until cur has none, then cur can go
+        if (cur->left != 0) {
+            struct SplayNode *left = cur->left;
+            cur->left = left->right;
+            left->right = cur;
+            cur = left;
+        }
+        else {
+            struct SplayNode *next = cur->right;
+            free(cur);
+            cur = next;
+        }
+    }
+    tree->root = 0;
+    tree->cnt = 0;
+}
+
+/*
+ function to deallocate a dynamically allocated splay tree
+ param: tree   the splay tree
+ pre: tree is not null
+ post: all nodes and the tree structure itself are deallocated.
+ */
+void deleteSplayTree(struct SplayTree *tree)
+{
+    clearSplayTree(tree);
+    free(tree);
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to determine if a splay tree is empty.
+ param: tree    the splay tree
+ pre:  tree is not null
+ */
+int isEmptySplayTree(struct SplayTree *tree)
+{
+    return (tree->cnt == 0);
+}
+
+/*
+ function to determine the size of a splay tree
+ param: tree    the splay tree
+ pre:  tree is not null
+ */
+int sizeSplayTree(struct SplayTree *tree)
+{
+    return tree->cnt;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to compare a value against the value in a node
+ param:	val		the value, or null to stand for one larger than any other
+		cur		the node
+ */
+static int _compare(TYPE val, struct SplayNode *cur)
+{
+    return (val == 0) ? 1 : compare(val, cur->val);
+}
+
+/*
+ helper function to splay a subtree.  The walk hangs the nodes that sort
+ before val on the right spine of a left tree and the ones after it on the
+ left spine of a right tree, and turns zig-zig steps into a rotation first
+ so long paths get about half as deep.
+ param:	cur		the root of the subtree, may be null
+		val		the value to look for, or null for the largest value
+ post:	returns the new root: a value equal to val if there is one,
+		otherwise the last value on the search path
+ */
+static struct SplayNode *_splay(struct SplayNode *cur, TYPE val)
+{
+    struct SplayNode header;
+    struct SplayNode *left = &header;
+    struct SplayNode *right = &header;
+    if (cur == 0) {
+        return 0;
+    }
+    header.left = header.right = 0;
+    //each node on the path is compared once, the result is carried down
+    int cmp = _compare(val, cur);
+    while (cmp != 0) {
+        if (cmp < 0) {
+            struct SplayNode *child = cur->left;
+            if (child == 0) {
+                break;
+            }
+            cmp = _compare(val, child);
+            //zig-zig: rotate right before moving on
+            if (cmp < 0) {
+                cur->left = child->right;
+                child->right = cur;
+                cur = child;
+                if (cur->left == 0) {
+                    break;
+                }
+                child = cur->left;
+                cmp = _compare(val, child);
+            }
+            //cur and its right subtree sort after val
+            right->left = cur;
+            right = cur;
+            cur = child;
+        }
+        else {
+            struct SplayNode *child = cur->right;
+            if (child == 0) {
+                break;
+            }
+            cmp = _compare(val, child);
+            //zig-zig: rotate left before moving on
+            if (cmp > 0) {
+                cur->right = child->left;
+                child->left = cur;
+                cur = child;
+                if (cur->right == 0) {
+                    break;
+                }
+                child = cur->right;
+                cmp = _compare(val, child);
+            }
+            //cur and its left subtree sort before val
+            left->right = cur;
+            left = cur;
+            cur = child;
+        }
+    }
+    //put the left and right trees back together under cur
+    left->right = cur->left;
+    right->left = cur->right;
+    cur->left = header.right;
+    cur->right = header.left;
+    return cur;
+}
+
+/*
+ function to add a value to the splay tree
+ param: tree   the splay tree
+		val		the value to be added to the tree
+ pre:	tree is not null
+		val is not null
+ post:  tree size increased by 1
+		val is at the root
+ */
+void addSplayTree(struct SplayTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    struct SplayNode *new = malloc(sizeof(struct SplayNode));
+    assert(new != 0);
+    new->val = val;
+    new->left = new->right = 0;
+    struct SplayNode *root = _splay(tree->root, val);
+    //the old root becomes a child of the new one on the side it sorts
+    if (root != 0) {
+        if (compare(val, root->val) < 0) {
+            new->left = root->left;
+            new->right = root;
+            root->left = 0;
+        }
+        else {
+            new->right = root->right;
+            new->left = root;
+            root->right = 0;
+        }
+    }
+    tree->root = new;
+    tree->cnt++;
+}
+
+/*
+ function to determine if the splay tree contains a particular element
+ param:	tree	the splay tree
+		val		the value to search for in the tree
+ pre:	tree is not null
+		val is not null
+ post:	return 1 if found, else return 0 if not found
+		the value found, or the last one looked at, is at the root
+ */
+int containsSplayTree(struct SplayTree *tree, TYPE val)
+{
+    assert(tree != 0 && val != 0);
+    tree->root = _splay(tree->root, val);
+    return tree->root != 0 && compare(val, tree->root->val) == 0;
+}
+
+/*
+ function to remove a value from the splay tree
+ param: tree   the splay tree
+		val		the value to be removed from the tree
+ pre:	tree is not null
+		val is not null
+ pose:	tree size is reduced by 1 if val was in the tree
+ */
+void removeSplayTree(struct SplayTree *tree, TYPE val)
+{
+    if (!containsSplayTree(tree, val)) {
+        return;
+    }
+    struct SplayNode *root = tree->root;
+    //the largest value on the left has no right child and can take over
+    if (root->left == 0) {
+        tree->root = root->right;
+    }
+    else {
+        tree->root = _splay(root->left, 0);
+        tree->root->right = root->right;
+    }
+    free(root);
+    tree->cnt--;
+}
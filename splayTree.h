@@ -0,0 +1,47 @@
+/*
+  File: splayTree.h
+  Interface definition of a splay tree with the same bag operations as
+  bst.h.  Every add, contains and remove moves the value it looks for to
+  the root, so values that are looked up often stay a few levels down and
+  a skewed workload costs far fewer node visits than in a balanced tree.
+  Any single operation can still be O(n); a sequence of them is
+  O(log n) each on average.
+
+  Because contains changes the tree, it is not safe to call from several
+  threads at once, not even for lookups only.
+*/
+
+#ifndef __SPLAY_TREE_H
+#define __SPLAY_TREE_H
+
+# ifndef TYPE
+# define TYPE      void*
+# endif
+
+/* function used to compare two TYPE values to each other, define this in
+   your compare.c file (see compare in bst.h) */
+int compare(TYPE left, TYPE right);
+
+struct SplayTree;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Initialize splay tree structure. */
+void initSplayTree(struct SplayTree *tree);
+
+/* Alocate and initialize splay tree structure. */
+struct SplayTree *newSplayTree();
+
+/* Deallocate nodes in the splay tree. */
+void clearSplayTree(struct SplayTree *tree);
+
+/* Deallocate nodes in the splay tree and deallocate the splay tree structure. */
+void deleteSplayTree(struct SplayTree *tree);
+
+/*-- Splay tree Bag interface --*/
+int  isEmptySplayTree(struct SplayTree *tree);
+int     sizeSplayTree(struct SplayTree *tree);
+
+void     addSplayTree(struct SplayTree *tree, TYPE val);
+int containsSplayTree(struct SplayTree *tree, TYPE val);
+void  removeSplayTree(struct SplayTree *tree, TYPE val);
+# endif
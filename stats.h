@@ -0,0 +1,41 @@
+/*
+  File: stats.h
+  Performance counters shared by the containers.  Build with
+  -DCOLLECT_STATS to have bst.c, linkedList.c (or unrolledList.c) and
+  circularList.c count their operations, comparisons and allocations; without it the counters
+  are not in the structures and the STAT_ macros compile to nothing, so
+  the hot paths cost exactly what they did before.
+
+  The shape of a structure (size, nodes, bytes, height and average depth)
+  is measured when the stats are read, so it is filled in either way.
+*/
+
+#ifndef __STATS_H
+#define __STATS_H
+
+struct Stats {
+	/* counted with COLLECT_STATS only, 0 otherwise */
+	long   adds;		/* values added */
+	long   removes;		/* values removed */
+	long   lookups;		/* searches: contains, and removes by value */
+	long   compares;	/* value comparisons made by all of the above */
+	long   allocated;	/* nodes or links allocated */
+	long   freed;		/* nodes or links freed */
+	/* measured by the get function */
+	long   size;		/* values held */
+	long   nodes;		/* nodes or links holding them */
+	long   bytes;		/* memory held, including the structure itself */
+	int    height;		/* trees: levels, 0 when empty */
+	double avgDepth;	/* trees: mean depth of a node, the root is 0 */
+};
+
+/* Counters are bumped with relaxed atomics, so readers of a BST_CONCURRENT
+ * tree can count their lookups without a data race. */
+# ifdef COLLECT_STATS
+# define STAT_ADD(counter, n) __atomic_fetch_add(&(counter), (n), __ATOMIC_RELAXED)
+# else
+# define STAT_ADD(counter, n) ((void)0)
+# endif
+# define STAT_INC(counter) STAT_ADD(counter, 1)
+
+# endif
@@ -0,0 +1,412 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: threadPool.c
+*
+* Solution description: A fixed set of workers, each with a
+* work-stealing deque.  A worker pops its own deque first,
+* then steals from the others starting at a random one, then
+* takes from a locked queue that holds the tasks spawned by
+* threads outside the pool.  A waiter first takes its own
+* task back if nobody has started it, which is the common
+* case; otherwise it runs other tasks until its own is done,
+* so a fork/join tree of tasks never idles a thread that
+* waits.  Helping is capped in depth, as every task it runs
+* sits on the waiter's stack.
+*
+* A worker that finds nothing yields a few times and then
+* sleeps on a condition variable.  Spawning only takes the
+* lock when someone sleeps: the spawner publishes its task
+* before it reads the sleeper count, and a worker counts
+* itself before it looks for work one last time, so one of
+* them always sees the other.  The wakeup counter closes the
+* gap between that last look and the wait.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "threadPool.h"
+#include "workDeque.h"
+#include "epoch.h"
+
+/* Rounds of looking for work before an idle worker sleeps */
+# ifndef POOL_SPIN
+# define POOL_SPIN 64
+# endif
+
+/* Tasks a waiter may run nested inside one another while its own task
+   runs elsewhere; each one is a stack frame the waiter cannot leave */
+# ifndef POOL_HELP_DEPTH
+# define POOL_HELP_DEPTH 16
+# endif
+
+struct PoolWorker {
+	struct ThreadPool  *pool;
+	struct WorkDeque   *deque;
+	pthread_t           thread;
+};
+
+struct ThreadPool {
+	int                 threads;
+	struct PoolWorker  *workers;
+	atomic_int          sleeping;	/* workers asleep or about to be */
+	atomic_int          queued;		/* tasks in the outside queue */
+	pthread_mutex_t     lock;		/* guards the fields below */
+	pthread_cond_t      wake;
+	long                wakeups;	/* bumped by every wake */
+	int                 stopping;
+	struct PoolTask    *front;		/* tasks spawned from outside, oldest first */
+	struct PoolTask    *back;
+};
+
+/* The worker the calling thread is, if any */
+static _Thread_local struct PoolWorker *self = 0;
+static _Thread_local unsigned int rngState = 0;
+static _Thread_local int helping = 0;	/* tasks run inside waits */
+
+static struct ThreadPool *shared = 0;
+static pthread_once_t sharedOnce = PTHREAD_ONCE_INIT;
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to run a task and mark it done
+ */
+static void _runTask(struct PoolTask *task)
+{
+    task->fn(task->arg);
+    //the release hands the task's results to the waiter
+    atomic_store_explicit(&task->done, 1, memory_order_release);
+}
+
+/*
+ helper function to wake one sleeping worker, if there is one
+ pre:	the new work is already visible
+ */
+static void _wakeOne(struct ThreadPool *pool)
+{
+    //pairs with the count a worker takes before its last look for work
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&pool->sleeping, memory_order_relaxed) == 0) {
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->wakeups++;
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ helper function to take a task from the outside queue
+ post:	returns the oldest such task, or 0
+ */
+static struct PoolTask *_takeQueued(struct ThreadPool *pool)
+{
+    if (atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&pool->lock);
+    struct PoolTask *task = pool->front;
+    if (task != 0) {
+        pool->front = task->next;
+        if (pool->front == 0) {
+            pool->back = 0;
+        }
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return task;
+}
+
+/*
+ helper function to take a task back out of the outside queue
+ post:	returns 1 if task was still there, else 0
+ */
+static int _unqueue(struct ThreadPool *pool, struct PoolTask *task)
+{
+    if (atomic_load_explicit(&pool->queued, memory_order_acquire) == 0) {
+        return 0;
+    }
+    pthread_mutex_lock(&pool->lock);
+    struct PoolTask **prev = &pool->front;
+    struct PoolTask *last = 0;
+    while (*prev != 0 && *prev != task) {
+        last = *prev;
+        prev = &last->next;
+    }
+    int found = (*prev == task);
+    if (found) {
+        *prev = task->next;
+        if (pool->back == task) {
+            pool->back = last;
+        }
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return found;
+}
+
+/*
+ helper function to find a task to run
+ param:	pool	the pool
+		me		the calling worker, or 0 for a thread outside the pool
+ post:	returns a task taken from me's deque, another worker's deque or
+		the outside queue, or 0 if none had one
+ */
+static struct PoolTask *_findTask(struct ThreadPool *pool, struct PoolWorker *me)
+{
+    void *item;
+    if (me != 0 && (item = workDequePopBottom(me->deque)) != 0) {
+        return item;
+    }
+    //start at a random victim so thieves spread out
+    rngState = rngState * 1103515245u + 12345u;
+    int start = (pool->threads > 0) ? (int)((rngState >> 16) % (unsigned int)pool->threads) : 0;
+    for (int i = 0; i < pool->threads; i++) {
+        struct PoolWorker *victim = &pool->workers[(start + i) % pool->threads];
+        if (victim == me) {
+            continue;
+        }
+        int got;
+        while ((got = workDequeSteal(victim->deque, &item)) == WORK_RETRY) {
+        }
+        if (got == WORK_STOLEN) {
+            return item;
+        }
+    }
+    return _takeQueued(pool);
+}
+
+/*
+ helper function to tell if any task is waiting to be taken
+ */
+static int _hasWork(struct ThreadPool *pool)
+{
+    if (atomic_load(&pool->queued) != 0) {
+        return 1;
+    }
+    for (int i = 0; i < pool->threads; i++) {
+        if (!workDequeIsEmpty(pool->workers[i].deque)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ helper function to put an idle worker to sleep until there may be work
+ post:	returns 1 if the pool is stopping, else 0
+ */
+static int _sleep(struct ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    long seen = pool->wakeups;
+    int stopping = pool->stopping;
+    pthread_mutex_unlock(&pool->lock);
+    if (stopping) {
+        return 1;
+    }
+    //count ourselves first, then look: a spawner that missed the count
+    //published its task before it looked, so we see the task
+    atomic_fetch_add(&pool->sleeping, 1);
+    if (!_hasWork(pool)) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->wakeups == seen && !pool->stopping) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+    atomic_fetch_sub(&pool->sleeping, 1);
+    return 0;
+}
+
+/*
+ thread entry point of a worker
+ */
+static void *_worker(void *arg)
+{
+    struct PoolWorker *me = arg;
+    struct ThreadPool *pool = me->pool;
+    self = me;
+    rngState = (unsigned int)(me - pool->workers) + 1;
+    int idle = 0;
+    for (;;) {
+        struct PoolTask *task = _findTask(pool, me);
+        if (task != 0) {
+            _runTask(task);
+            idle = 0;
+        }
+        else if (++idle < POOL_SPIN) {
+            sched_yield();
+        }
+        else {
+            idle = 0;
+            if (_sleep(pool)) {
+                break;
+            }
+        }
+    }
+    epochThreadExit();
+    return 0;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to start a pool
+ param:	threads	number of workers, 0 for one per processor less one
+ post:	the workers are running and idle
+ */
+struct ThreadPool *threadPoolCreate(int threads)
+{
+    assert(threads >= 0);
+    if (threads == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 1) ? (int)cpus - 1 : 0;
+    }
+    struct ThreadPool *pool = malloc(sizeof(struct ThreadPool));
+    assert(pool != 0);
+    pool->threads = threads;
+    pool->workers = malloc((threads + 1) * sizeof(struct PoolWorker));
+    assert(pool->workers != 0);
+    atomic_init(&pool->sleeping, 0);
+    atomic_init(&pool->queued, 0);
+    pthread_mutex_init(&pool->lock, 0);
+    pthread_cond_init(&pool->wake, 0);
+    pool->wakeups = 0;
+    pool->stopping = 0;
+    pool->front = pool->back = 0;
+    //every deque exists before any worker can go looking in it
+    for (int i = 0; i < threads; i++) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].deque = workDequeCreate(64);
+    }
+    for (int i = 0; i < threads; i++) {
+        int started = pthread_create(&pool->workers[i].thread, 0, _worker, &pool->workers[i]);
+        assert(started == 0);
+        (void)started;
+    }
+    return pool;
+}
+
+/*
+ function to stop a pool
+ param:	pool	the pool
+ pre:	no task is pending
+ post:	the workers have exited and the pool is freed
+ */
+void threadPoolDestroy(struct ThreadPool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pool->wakeups++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+    //every worker may steal from every deque until it has exited
+    for (int i = 0; i < pool->threads; i++) {
+        pthread_join(pool->workers[i].thread, 0);
+    }
+    for (int i = 0; i < pool->threads; i++) {
+        workDequeDestroy(pool->workers[i].deque);
+    }
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+static void _makeShared(void)
+{
+    shared = threadPoolCreate(0);
+}
+
+/*
+ function to get the process wide pool
+ */
+struct ThreadPool *threadPoolShared(void)
+{
+    pthread_once(&sharedOnce, _makeShared);
+    return shared;
+}
+
+/*
+ function to get the number of workers of a pool
+ */
+int threadPoolThreads(struct ThreadPool *pool)
+{
+    return pool->threads;
+}
+
+/*
+ function to queue a task
+ param:	pool	the pool
+		task	the task, owned by the caller
+		fn		the function to run
+		arg		its argument
+ post:	a worker's own spawns go on its deque, others on the outside queue
+ */
+void threadPoolSpawn(struct ThreadPool *pool, struct PoolTask *task,
+                     void (*fn)(void *arg), void *arg)
+{
+    task->fn = fn;
+    task->arg = arg;
+    atomic_store_explicit(&task->done, 0, memory_order_relaxed);
+    task->next = 0;
+    if (self != 0 && self->pool == pool) {
+        workDequePushBottom(self->deque, task);
+    }
+    else {
+        pthread_mutex_lock(&pool->lock);
+        if (pool->back != 0)
+            pool->back->next = task;
+        else
+            pool->front = task;
+        pool->back = task;
+        atomic_fetch_add_explicit(&pool->queued, 1, memory_order_release);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    _wakeOne(pool);
+}
+
+/*
+ function to wait for a task
+ param:	pool	the pool the task was spawned on
+		task	the task
+ post:	the task has run and its results are visible to the caller
+ */
+void threadPoolWait(struct ThreadPool *pool, struct PoolTask *task)
+{
+    struct PoolWorker *me = (self != 0 && self->pool == pool) ? self : 0;
+    //tasks are waited for in the reverse order of their spawns, so one
+    //nobody took is the newest in our deque, or still in the outside queue
+    if (me != 0) {
+        struct PoolTask *newest = workDequePopBottom(me->deque);
+        if (newest == task) {
+            _runTask(task);
+            return;
+        }
+        if (newest != 0) {
+            workDequePushBottom(me->deque, newest);
+        }
+    }
+    else if (_unqueue(pool, task)) {
+        _runTask(task);
+        return;
+    }
+    //someone else runs it; help with other tasks meanwhile, but only so
+    //deep, as each one holds on to our stack until it returns
+    while (!atomic_load_explicit(&task->done, memory_order_acquire)) {
+        struct PoolTask *other = (helping < POOL_HELP_DEPTH) ? _findTask(pool, me) : 0;
+        if (other != 0) {
+            helping++;
+            _runTask(other);
+            helping--;
+        }
+        else {
+            sched_yield();
+        }
+    }
+}
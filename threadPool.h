@@ -0,0 +1,48 @@
+/*
+  File: threadPool.h
+  Interface definition of a fork/join thread pool.  Each worker keeps the
+  tasks it spawns in its own work-stealing deque (workDeque.h) and runs
+  them newest first; idle workers steal the oldest, and so the biggest,
+  tasks of the others.  A thread waiting for a task runs other tasks in
+  the meantime, so tasks may spawn and wait for tasks of their own without
+  tying up a worker.  Link with workDeque.c and epoch.c; tasks may use
+  epoch.c, the workers give their slot back before they exit.
+*/
+
+#ifndef __THREAD_POOL_H
+#define __THREAD_POOL_H
+
+#include <stdatomic.h>
+
+/* A unit of work.  It belongs to the caller, who keeps it alive and
+ * unchanged from threadPoolSpawn until threadPoolWait returns. */
+struct PoolTask {
+	void            (*fn)(void *arg);
+	void             *arg;
+	atomic_int        done;
+	struct PoolTask  *next;	/* queued by a thread outside the pool */
+};
+
+struct ThreadPool;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Start a pool with the given number of workers, or one per processor
+ * but the caller's if threads is 0. */
+struct ThreadPool *threadPoolCreate(int threads);
+/* Stop and join the workers.  No task may be pending. */
+void threadPoolDestroy(struct ThreadPool *pool);
+
+/* The pool the containers split their work over, started on first use
+ * and never destroyed. */
+struct ThreadPool *threadPoolShared(void);
+/* Number of workers, not counting threads that wait. */
+int  threadPoolThreads(struct ThreadPool *pool);
+
+/*-- Fork/join, safe to call from any thread --*/
+/* Queue fn(arg) to run on some thread of the pool, or on a waiter. */
+void threadPoolSpawn(struct ThreadPool *pool, struct PoolTask *task,
+                     void (*fn)(void *arg), void *arg);
+/* Return once task has run, running other tasks until it has. */
+void threadPoolWait(struct ThreadPool *pool, struct PoolTask *task);
+
+# endif
@@ -0,0 +1,658 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: unrolledList.c
+*
+* Solution description: An unrolled linked list behind the
+* same deque and bag interface as linkedList.c; link a program
+* with one or the other.  Values are packed into chunks of
+* CHUNK_BYTES bytes, a multiple of the cache line, that each
+* hold a run values[start .. start + count) of many values,
+* so a push or pop at either end is an array store and a
+* contains is a linear scan over a few contiguous runs.  The
+* two pointers a chunk spends on its neighbours are shared by
+* all of its values instead of costing 16 bytes each.
+*
+* Values only ever go in at the ends: a full end chunk gets a
+* new neighbour and a chunk with room left slides its run
+* over, so no chunk ever has to be split.  A bag remove that
+* leaves a chunk at most half full merges it into a neighbour
+* when the two fit in one chunk, which keeps chunks away from
+* the ends at least half full on average.
+*
+* When TYPE is int the bag scans of each run go through the
+* SSE2/AVX2/AVX-512 kernels of bagScan.c.
+************************************************************/
+#include "linkedList.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "writer.h"
+#include "bagScan.h"
+
+#ifndef FORMAT_SPECIFIER
+#define FORMAT_SPECIFIER "%d"
+#endif
+
+// Writes one TYPE value for linkedListExport
+#ifndef WRITE_TYPE
+#define WRITE_TYPE(W, V) writeInt(W, V)
+#endif
+
+// Size of a chunk including its header, a multiple of the 64 byte cache line
+#ifndef CHUNK_BYTES
+#define CHUNK_BYTES 256
+#endif
+
+#if CHUNK_BYTES % 64 != 0
+#error CHUNK_BYTES must be a multiple of 64
+#endif
+
+// Run of values with links to the chunks before and after it
+struct Chunk
+{
+	struct Chunk* next;
+	struct Chunk* prev;
+	int start;	// index of the first value
+	int count;	// number of values, they fill values[start .. start + count)
+	TYPE values[];
+};
+
+// 1 when TYPE is int, so the bag scans can use the kernels of bagScan.c;
+// they compare with ==, as EQ does unless it is redefined
+#define INT_VALUES _Generic((TYPE)0, int: 1, default: 0)
+// The value as an int when TYPE is int, so the kernel calls compile for
+// any TYPE
+#define INT_VALUE(V) _Generic((V), int: (V), default: 0)
+
+// Number of values that fit in a chunk
+#define CHUNK_VALUES ((int)((CHUNK_BYTES - sizeof(struct Chunk)) / sizeof(TYPE)))
+
+// Double linked list of chunks, both ends are null when it is empty
+struct LinkedList
+{
+	struct Chunk* front;
+	struct Chunk* back;
+	struct Chunk* spare;	// an emptied chunk kept for the next one needed
+	int size;
+	int chunks;
+#ifdef COLLECT_STATS
+	struct Stats stats;
+#endif
+};
+
+/**
+	Gets an empty chunk, the spare one if there is one.
+	param: 	list 	struct LinkedList ptr
+	pre: 	         list is not null
+	post: 	returns a chunk that is not linked into the list
+ */
+static struct Chunk* newChunk(struct LinkedList* list)
+{
+    struct Chunk *chunk = list->spare;
+    if (chunk != 0) {
+        list->spare = 0;
+    }
+    else {
+        //cache line aligned, so a scan touches as few lines as possible
+        chunk = aligned_alloc(64, CHUNK_BYTES);
+        assert(chunk != 0);
+        STAT_INC(list->stats.allocated);
+    }
+    list->chunks++;
+    return chunk;
+}
+
+/**
+	Unlinks a chunk from the list and keeps it as the spare, or frees it
+	if there already is one.
+	param: 	list 	struct LinkedList ptr
+	param:	chunk 	struct Chunk ptr
+	pre: 	         list and chunk are not null, chunk is in list
+	post: 	chunk is no longer in list
+ */
+static void removeChunk(struct LinkedList* list, struct Chunk* chunk)
+{
+    //point the neighbours, or the ends of the list, past chunk
+    if (chunk->prev != 0)
+        chunk->prev->next = chunk->next;
+    else
+        list->front = chunk->next;
+    if (chunk->next != 0)
+        chunk->next->prev = chunk->prev;
+    else
+        list->back = chunk->prev;
+    list->chunks--;
+    //keeping one chunk back stops a push and pop at a chunk boundary
+    //from calling malloc and free every time
+    if (list->spare == 0) {
+        list->spare = chunk;
+    }
+    else {
+        free(chunk);
+        STAT_INC(list->stats.freed);
+    }
+}
+
+/**
+	Moves the values of a chunk into the one before it and removes it.
+	param: 	list 	struct LinkedList ptr
+	param:	chunk 	struct Chunk ptr
+	pre: 	         chunk->prev is not null and the values of both fit in one
+	post: 	chunk->prev holds the values of both, in order, from index 0
+ */
+static void mergeChunk(struct LinkedList* list, struct Chunk* chunk)
+{
+    struct Chunk *prev = chunk->prev;
+    assert(prev->count + chunk->count <= CHUNK_VALUES);
+    //pack the run of prev at the start, then append the run of chunk
+    memmove(prev->values, prev->values + prev->start, prev->count * sizeof(TYPE));
+    prev->start = 0;
+    memcpy(prev->values + prev->count, chunk->values + chunk->start, chunk->count * sizeof(TYPE));
+    prev->count += chunk->count;
+    removeChunk(list, chunk);
+}
+
+/**
+	Returns the index of the first value in a run equal to the given one.
+	param:	values	TYPE ptr, the run
+	param:	n	number of values in the run
+	param: 	value 	TYPE
+	ret:	         the index, or -1 if there is none
+ */
+static int findInRun(TYPE* values, int n, TYPE value)
+{
+    if (INT_VALUES)
+        return bagScanFind((const int*)values, n, INT_VALUE(value));
+    for (int i = 0; i < n; i++) {
+        if (EQ(values[i], value))
+            return i;
+    }
+    return -1;
+}
+
+/**
+	Returns how many values in a run are equal to the given one.
+	param:	values	TYPE ptr, the run
+	param:	n	number of values in the run
+	param: 	value 	TYPE
+ */
+static int countInRun(TYPE* values, int n, TYPE value)
+{
+    if (INT_VALUES)
+        return bagScanCount((const int*)values, n, INT_VALUE(value));
+    int count = 0;
+    for (int i = 0; i < n; i++)
+        count += EQ(values[i], value);
+    return count;
+}
+
+/**
+	Removes the values in a run equal to the given one.
+	param:	values	TYPE ptr, the run
+	param:	n	number of values in the run
+	param: 	value 	TYPE
+	post:	the other values are packed in order at the start of the run
+	ret:	         how many values are left
+ */
+static int removeAllInRun(TYPE* values, int n, TYPE value)
+{
+    if (INT_VALUES)
+        return bagScanRemoveAll((int*)values, n, INT_VALUE(value));
+    int kept = 0;
+    for (int i = 0; i < n; i++) {
+        if (!EQ(values[i], value))
+            values[kept++] = values[i];
+    }
+    return kept;
+}
+
+/**
+	Allocates the list with no chunks and sets the size to 0.
+	param: 	list 	struct LinkedList ptr
+	pre: 	         list is not null
+	post: 	list front, back and spare are null
+			list size is 0
+ */
+static void init(struct LinkedList* list) {
+    //list is not null
+    assert(list != 0);
+    list->front = 0;
+    list->back = 0;
+    list->spare = 0;
+    list->size = 0;
+    list->chunks = 0;
+#ifdef COLLECT_STATS
+    //start the counters at zero
+    memset(&list->stats, 0, sizeof(list->stats));
+#endif
+}
+
+/**
+	Allocates and initializes a list.
+	pre: 	         none
+	post: 	memory allocated for new struct LinkedList ptr
+			list init (call to init func)
+	return:       list
+ */
+struct LinkedList* linkedListCreate()
+{
+	struct LinkedList* list = malloc(sizeof(struct LinkedList));
+	init(list);
+	return list;
+}
+
+/**
+	Deallocates every chunk in the list, and frees the list itself.
+	param:	list 	struct LinkedList ptr
+	pre: 	         list is not null
+	post: 	memory allocated to each chunk and the spare is freed
+			" " list " "
+ */
+void linkedListDestroy(struct LinkedList* list)
+{
+	assert(list != NULL);
+	struct Chunk *chunk = list->front;
+	while (chunk != 0) {
+		struct Chunk *next = chunk->next;
+		free(chunk);
+		STAT_INC(list->stats.freed);
+		chunk = next;
+	}
+	if (list->spare != 0) {
+		free(list->spare);
+		STAT_INC(list->stats.freed);
+	}
+	free(list);
+	list = NULL;
+}
+
+/**Deque implementation */
+
+/**
+	Adds a value to the front of the deque.
+	param: 	deque 	struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	        deque is not null
+	post: 	value is stored before the current first value
+ */
+void linkedListAddFront(struct LinkedList* deque, TYPE value)
+{
+    //deque is not null
+    assert(deque != 0);
+    struct Chunk *chunk = deque->front;
+    //no room before the first value of the front chunk
+    if (chunk == 0 || chunk->start == 0) {
+        //room after it: slide the run to the end, once per chunk
+        if (chunk != 0 && chunk->count < CHUNK_VALUES) {
+            int start = CHUNK_VALUES - chunk->count;
+            memmove(chunk->values + start, chunk->values, chunk->count * sizeof(TYPE));
+            chunk->start = start;
+        }
+        //full: a new front chunk that fills from its end
+        else {
+            struct Chunk *new = newChunk(deque);
+            new->start = CHUNK_VALUES;
+            new->count = 0;
+            new->prev = 0;
+            new->next = chunk;
+            if (chunk != 0)
+                chunk->prev = new;
+            else
+                deque->back = new;
+            deque->front = new;
+            chunk = new;
+        }
+    }
+    chunk->values[--chunk->start] = value;
+    chunk->count++;
+    deque->size++;
+    STAT_INC(deque->stats.adds);
+}
+
+/**
+	Adds a value to the back of the deque.
+	param: 	deque 	struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         deque is not null
+	post: 	value is stored after the current last value
+ */
+void linkedListAddBack(struct LinkedList* deque, TYPE value)
+{
+	//deque is not null
+    assert(deque != 0);
+    struct Chunk *chunk = deque->back;
+    //no room after the last value of the back chunk
+    if (chunk == 0 || chunk->start + chunk->count == CHUNK_VALUES) {
+        //room before it: slide the run to the start, once per chunk
+        if (chunk != 0 && chunk->count < CHUNK_VALUES) {
+            memmove(chunk->values, chunk->values + chunk->start, chunk->count * sizeof(TYPE));
+            chunk->start = 0;
+        }
+        //full: a new back chunk that fills from its start
+        else {
+            struct Chunk *new = newChunk(deque);
+            new->start = 0;
+            new->count = 0;
+            new->next = 0;
+            new->prev = chunk;
+            if (chunk != 0)
+                chunk->next = new;
+            else
+                deque->front = new;
+            deque->back = new;
+            chunk = new;
+        }
+    }
+    chunk->values[chunk->start + chunk->count++] = value;
+    deque->size++;
+    STAT_INC(deque->stats.adds);
+}
+
+/**
+	Returns the value at the front of the deque.
+	param: 	deque 	struct LinkedList ptr
+	pre:	         deque is not null
+	pre:	         deque is not empty
+	post:	         none
+	ret:	         first value
+ */
+TYPE linkedListFront(struct LinkedList* deque)
+{
+	//deque is not null and not empty
+    assert(deque != 0 && !linkedListIsEmpty(deque));
+    return deque->front->values[deque->front->start];
+}
+
+/**
+	Returns the value at the back of the deque.
+	param: 	deque 	struct LinkedList ptr
+	pre:	         deque is not null
+	pre:	         deque is not empty
+	post:	         none
+	ret:	         last value
+ */
+TYPE linkedListBack(struct LinkedList* deque)
+{
+    //deque is not null and not empty
+    assert(deque != 0 && !linkedListIsEmpty(deque));
+    struct Chunk *chunk = deque->back;
+    return chunk->values[chunk->start + chunk->count - 1];
+}
+
+/**
+	Removes the value at the front of the deque.
+	param: 	deque 	struct LinkedList ptr
+	pre:	         deque is not null
+	pre:	         deque is not empty
+	post:	         first value is removed, and its chunk if it was the last
+			one there (call to removeChunk)
+ */
+void linkedListRemoveFront(struct LinkedList* deque)
+{
+    //deque is not null and not empty
+    assert(deque != 0 && !linkedListIsEmpty(deque));
+    struct Chunk *chunk = deque->front;
+    chunk->start++;
+    deque->size--;
+    STAT_INC(deque->stats.removes);
+    if (--chunk->count == 0)
+        removeChunk(deque, chunk);
+}
+
+/**
+	Removes the value at the back of the deque.
+	param: 	deque 	struct LinkedList ptr
+	pre:	         deque is not null
+	pre:	         deque is not empty
+	post:	         last value is removed, and its chunk if it was the last
+			one there (call to removeChunk)
+ */
+void linkedListRemoveBack(struct LinkedList* deque)
+{
+    //deque is not null and not empty
+    assert(deque != 0 && !linkedListIsEmpty(deque));
+    struct Chunk *chunk = deque->back;
+    deque->size--;
+    STAT_INC(deque->stats.removes);
+    if (--chunk->count == 0)
+        removeChunk(deque, chunk);
+}
+
+/**
+	Returns 1 if the deque is empty and 0 otherwise.
+	param:	deque	struct LinkedList ptr
+	pre:	         deque is not null
+	post:	         none
+	ret:	         1 if its size is 0 (empty), otherwise 0 (not empty)
+ */
+int linkedListIsEmpty(struct LinkedList* deque)
+{
+	//deque is not null
+    assert(deque != 0);
+    return deque->size == 0;
+}
+
+/**
+	Prints the values in the deque from front to back.
+	param:	deque	struct LinkedList ptr
+	pre:	         deque is not null
+	post:   	none
+	ret:	         outputs to the console the values from front to back;
+			if empty, prints msg that is empty
+ */
+void linkedListPrint(struct LinkedList* deque)
+{
+	//deque is not null
+    assert(deque != 0);
+    //if empty print msg empty
+    if (linkedListIsEmpty(deque))
+        printf("Deque is Empty\n");
+    //print the run of every chunk in turn
+    else {
+        for (struct Chunk *chunk = deque->front; chunk != 0; chunk = chunk->next) {
+            for (int i = chunk->start; i < chunk->start + chunk->count; i++)
+                printf(FORMAT_SPECIFIER "\n", chunk->values[i]);
+        }
+    }
+}
+
+/** Bag Interface */
+/**
+	Adds a value to the bag.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post: 	value is stored before the current first value, as in
+			linkedList.c (call to linkedListAddFront)
+ */
+void linkedListAdd(struct LinkedList* bag, TYPE value)
+{
+	//bag is not null
+    assert(bag != 0);
+    linkedListAddFront(bag, value);
+}
+
+/**
+	Returns 1 if the value is in the bag and 0 otherwise.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         none
+	ret:	         1 if given value found; otherwise, 0
+ */
+int linkedListContains(struct LinkedList* bag, TYPE value)
+{
+    //bag is not null
+    assert(bag != 0);
+    STAT_INC(bag->stats.lookups);
+    for (struct Chunk *chunk = bag->front; chunk != 0; chunk = chunk->next) {
+        STAT_ADD(bag->stats.compares, chunk->count);
+        if (findInRun(chunk->values + chunk->start, chunk->count, value) >= 0)
+            return 1;
+    }
+    //was not found in the bag, return 0
+    return 0;
+}
+
+/**
+	Removes the first occurrence of the given value.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         if the value is found it is removed; its chunk is removed
+			when empty, or merged into a neighbour when at most half
+			full and both fit in one chunk
+ */
+void linkedListRemove(struct LinkedList* bag, TYPE value)
+{
+	//bag is not null
+    assert(bag != 0);
+    STAT_INC(bag->stats.lookups);
+    for (struct Chunk *chunk = bag->front; chunk != 0; chunk = chunk->next) {
+        TYPE *values = chunk->values + chunk->start;
+        int i = findInRun(values, chunk->count, value);
+        if (i < 0) {
+            STAT_ADD(bag->stats.compares, chunk->count);
+            continue;
+        }
+        STAT_ADD(bag->stats.compares, i + 1);
+        //close the gap from whichever side has fewer values to move
+        if (i < chunk->count - 1 - i) {
+            memmove(values + 1, values, i * sizeof(TYPE));
+            chunk->start++;
+        }
+        else {
+            memmove(values + i, values + i + 1, (chunk->count - 1 - i) * sizeof(TYPE));
+        }
+        chunk->count--;
+        bag->size--;
+        STAT_INC(bag->stats.removes);
+        if (chunk->count == 0)
+            removeChunk(bag, chunk);
+        else if (chunk->count <= CHUNK_VALUES / 2) {
+            if (chunk->prev != 0 && chunk->prev->count + chunk->count <= CHUNK_VALUES)
+                mergeChunk(bag, chunk);
+            else if (chunk->next != 0 && chunk->next->count + chunk->count <= CHUNK_VALUES)
+                mergeChunk(bag, chunk->next);
+        }
+        return;
+    }
+}
+
+/**
+	Returns the number of values in the bag equal to the given one.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         none
+	ret:	         how many values are equal to value
+ */
+int linkedListCount(struct LinkedList* bag, TYPE value)
+{
+    //bag is not null
+    assert(bag != 0);
+    int count = 0;
+    STAT_INC(bag->stats.lookups);
+    STAT_ADD(bag->stats.compares, bag->size);
+    for (struct Chunk *chunk = bag->front; chunk != 0; chunk = chunk->next)
+        count += countInRun(chunk->values + chunk->start, chunk->count, value);
+    return count;
+}
+
+/**
+	Removes every value in the bag equal to the given one.
+	param:	bag		struct LinkedList ptr
+	param: 	value 	TYPE
+	pre: 	         bag is not null
+	post:	         no value is equal to value; chunks left empty are
+			removed and ones left at most half full are merged into
+			the chunk before them when both fit in one
+	ret:	         how many values were removed
+ */
+int linkedListRemoveAll(struct LinkedList* bag, TYPE value)
+{
+    //bag is not null
+    assert(bag != 0);
+    int removed = 0;
+    STAT_INC(bag->stats.lookups);
+    STAT_ADD(bag->stats.compares, bag->size);
+    struct Chunk *chunk = bag->front;
+    while (chunk != 0) {
+        //merging only ever goes into the chunk before, so next stays put
+        struct Chunk *next = chunk->next;
+        int kept = removeAllInRun(chunk->values + chunk->start, chunk->count, value);
+        if (kept != chunk->count) {
+            removed += chunk->count - kept;
+            chunk->count = kept;
+            if (kept == 0)
+                removeChunk(bag, chunk);
+            else if (kept <= CHUNK_VALUES / 2 && chunk->prev != 0
+                     && chunk->prev->count + kept <= CHUNK_VALUES)
+                mergeChunk(bag, chunk);
+        }
+        chunk = next;
+    }
+    bag->size -= removed;
+    STAT_ADD(bag->stats.removes, removed);
+    return removed;
+}
+
+/**
+	Writes the values from front to back.
+	param:	list	struct LinkedList ptr
+	param:	w	struct Writer ptr, see writer.h
+	param:	format	EXPORT_TEXT or EXPORT_CSV for one value per line,
+			EXPORT_BINARY for the raw TYPE values
+	pre:	list and w are not null
+	post:	values are written through w (call to finishWriter to flush)
+	ret:	the number of values written
+ */
+int linkedListExport(struct LinkedList* list, struct Writer* w, int format)
+{
+    //list and w are not null
+    assert(list != 0 && w != 0);
+    for (struct Chunk *chunk = list->front; chunk != 0; chunk = chunk->next) {
+        //a run is already laid out as raw values
+        if (format == EXPORT_BINARY) {
+            writeBytes(w, chunk->values + chunk->start, chunk->count * sizeof(TYPE));
+            continue;
+        }
+        //text and CSV are the same with one column
+        for (int i = chunk->start; i < chunk->start + chunk->count; i++) {
+            WRITE_TYPE(w, chunk->values[i]);
+            writeChar(w, '\n');
+        }
+    }
+    return list->size;
+}
+
+/** Statistics */
+/**
+	Fills in the statistics of the list.
+	param:	list	struct LinkedList ptr
+	param:	stats	struct Stats ptr
+	pre:	         list and stats are not null
+	post:	         counters are copied if built with COLLECT_STATS,
+			otherwise 0; size, chunks and bytes are measured;
+			height and avgDepth are 0
+ */
+void linkedListGetStats(struct LinkedList* list, struct Stats* stats)
+{
+    //list and stats are not null
+    assert(list != 0 && stats != 0);
+#ifdef COLLECT_STATS
+    *stats = list->stats;
+#else
+    memset(stats, 0, sizeof(struct Stats));
+#endif
+    stats->size = list->size;
+    stats->nodes = list->chunks;
+    //the chunks, the spare and the list itself
+    stats->bytes = sizeof(struct LinkedList)
+                 + (list->chunks + (list->spare != 0)) * (long)CHUNK_BYTES;
+    stats->height = 0;
+    stats->avgDepth = 0;
+}
@@ -0,0 +1,199 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: workDeque.c
+*
+* Solution description: Chase and Lev's work-stealing deque,
+* with the C11 orderings of Le, Pop, Cohen and Zappa Nardelli.
+* Items sit in a circular array between top and bottom; the
+* owner moves bottom and thieves move top with a compare and
+* swap.  Both ends only meet over the last item, which the
+* owner then also claims with a compare and swap on top, so
+* an owner that never runs dry never pays for one.  Where the
+* paper uses fences, the stores and loads on top and bottom
+* are sequentially consistent themselves, which costs the
+* same on x86 and keeps thread sanitizers able to follow.
+*
+* A full array is replaced by one twice its size.  A thief
+* may still be reading the old one, so it is kept, chained
+* to the new one, until the deque is destroyed; as the sizes
+* double, that at most doubles the memory held.
+************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include <stdatomic.h>
+#include "workDeque.h"
+
+struct DequeArray {
+	long                 mask;		/* slots - 1, the slots are a power of two */
+	struct DequeArray   *older;		/* the array this one replaced */
+	void *_Atomic        items[];
+};
+
+/* top is written by thieves and bottom by the owner, so each gets a line */
+struct WorkDeque {
+	_Alignas(64) atomic_long        top;	/* the oldest item */
+	_Alignas(64) atomic_long        bottom;	/* one past the newest item */
+	struct DequeArray *_Atomic      array;
+};
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to allocate an array
+ param:	slots	number of items it holds, a power of two
+ */
+static struct DequeArray *_newArray(long slots)
+{
+    struct DequeArray *a = malloc(sizeof(struct DequeArray) + slots * sizeof(void *));
+    assert(a != 0);
+    a->mask = slots - 1;
+    a->older = 0;
+    return a;
+}
+
+/*
+ helper function to move the items into an array twice the size
+ param:	deque	the deque
+		a		its current array
+		t, b	top and bottom as the owner sees them
+ pre:	called by the owner
+ post:	returns the new array, which thieves see from now on
+ */
+static struct DequeArray *_grow(struct WorkDeque *deque, struct DequeArray *a, long t, long b)
+{
+    struct DequeArray *bigger = _newArray(2 * (a->mask + 1));
+    for (long i = t; i < b; i++) {
+        void *item = atomic_load_explicit(&a->items[i & a->mask], memory_order_relaxed);
+        atomic_store_explicit(&bigger->items[i & bigger->mask], item, memory_order_relaxed);
+    }
+    bigger->older = a;
+    //the release publishes the copied items along with the array
+    atomic_store_explicit(&deque->array, bigger, memory_order_release);
+    return bigger;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to allocate and initialize an empty deque
+ param:	capacity	items it holds before it first grows
+ */
+struct WorkDeque *workDequeCreate(int capacity)
+{
+    long slots = 16;
+    while (slots < capacity) {
+        slots *= 2;
+    }
+    struct WorkDeque *deque = aligned_alloc(64, sizeof(struct WorkDeque));
+    assert(deque != 0);
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    atomic_init(&deque->array, _newArray(slots));
+    return deque;
+}
+
+/*
+ function to deallocate a deque
+ param:	deque	the deque
+ pre:	no other thread is using it
+ post:	the deque and every array it had are freed, the items are not
+ */
+void workDequeDestroy(struct WorkDeque *deque)
+{
+    struct DequeArray *a = atomic_load(&deque->array);
+    while (a != 0) {
+        struct DequeArray *older = a->older;
+        free(a);
+        a = older;
+    }
+    free(deque);
+}
+
+/*
+ function to push an item at the bottom
+ param:	deque	the deque
+		item	the item, not null
+ pre:	called by the owner
+ */
+void workDequePushBottom(struct WorkDeque *deque, void *item)
+{
+    assert(item != 0);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    struct DequeArray *a = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    if (b - t > a->mask) {
+        a = _grow(deque, a, t, b);
+    }
+    atomic_store_explicit(&a->items[b & a->mask], item, memory_order_relaxed);
+    //thieves that see the new bottom see the item
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+}
+
+/*
+ function to pop the item at the bottom
+ param:	deque	the deque
+ pre:	called by the owner
+ post:	returns the item pushed last, or 0 if there is none
+ */
+void *workDequePopBottom(struct WorkDeque *deque)
+{
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    struct DequeArray *a = atomic_load_explicit(&deque->array, memory_order_relaxed);
+    //claim the slot first, then look at top: a thief either sees the
+    //claim or we see its steal
+    atomic_store_explicit(&deque->bottom, b, memory_order_seq_cst);
+    long t = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    if (t > b) {
+        //empty, put bottom back
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return 0;
+    }
+    void *item = atomic_load_explicit(&a->items[b & a->mask], memory_order_relaxed);
+    if (t == b) {
+        //the last item, thieves may be after it as well
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            item = 0;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return item;
+}
+
+/*
+ function to steal the item at the top
+ param:	deque	the deque
+		item	where the item goes
+ post:	returns WORK_STOLEN with *item set, WORK_EMPTY, or WORK_RETRY if
+		another thread took the top item first
+ */
+int workDequeSteal(struct WorkDeque *deque, void **item)
+{
+    long t = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+    if (t >= b) {
+        return WORK_EMPTY;
+    }
+    //read the item before claiming it; once top moves on the owner may
+    //reuse the slot
+    struct DequeArray *a = atomic_load_explicit(&deque->array, memory_order_acquire);
+    void *x = atomic_load_explicit(&a->items[t & a->mask], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return WORK_RETRY;
+    }
+    *item = x;
+    return WORK_STOLEN;
+}
+
+/*
+ function to tell if the deque is empty
+ param:	deque	the deque
+ */
+int workDequeIsEmpty(struct WorkDeque *deque)
+{
+    long t = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+    return b <= t;
+}
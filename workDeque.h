@@ -0,0 +1,38 @@
+/*
+  File: workDeque.h
+  Interface definition of a work-stealing deque (Chase and Lev).  It is
+  the deque of linkedList.h cut down to what a scheduler needs: one owner
+  thread pushes and pops at the bottom like a stack, and any number of
+  other threads steal from the top without locks.  Items are pointers and
+  must not be null; the circular array behind them grows as needed.
+*/
+
+#ifndef __WORK_DEQUE_H
+#define __WORK_DEQUE_H
+
+/* Results of workDequeSteal. */
+# define WORK_EMPTY  0	/* nothing to steal */
+# define WORK_STOLEN 1	/* *item is ours */
+# define WORK_RETRY  -1	/* lost a race for the top item, try again or elsewhere */
+
+struct WorkDeque;
+/* Declared in the c source file to hide the structure members from the user. */
+
+/* Alocate and initialize an empty deque with room for capacity items
+ * before it first grows; capacity is rounded up to a power of two. */
+struct WorkDeque *workDequeCreate(int capacity);
+/* Deallocate the deque.  No other thread may be using it. */
+void workDequeDestroy(struct WorkDeque *deque);
+
+/*-- Owner only --*/
+void  workDequePushBottom(struct WorkDeque *deque, void *item);
+/* The item pushed last, or 0 if the deque is empty. */
+void *workDequePopBottom(struct WorkDeque *deque);
+
+/*-- Any thread --*/
+/* Take the oldest item into *item; see the WORK_ results above. */
+int   workDequeSteal(struct WorkDeque *deque, void **item);
+/* 1 if the deque held no items at some point during the call. */
+int   workDequeIsEmpty(struct WorkDeque *deque);
+
+# endif
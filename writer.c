@@ -0,0 +1,658 @@
+/***********************************************************
+* Author: Darci Martin
+* Email: martdarc@oregonstate.edu
+* Date Created: 2026-10-17
+* Filename: writer.c
+*
+* Solution description: Buffered output for the export
+* functions.  Bytes are copied into one large buffer that goes
+* out in a single write() when it fills, so the cost per value
+* is a memcpy of a few bytes.  Integers are turned into digits
+* two at a time from a table.  A double is first tried as a
+* fixed point number with as few decimals as will read back
+* exactly, which covers values like 0.1 or 12.375 with integer
+* arithmetic only.  Anything else goes through Loitsch's
+* Grisu3, which finds the shortest digits with 64 bit integer
+* arithmetic and knows when it cannot be sure of them; for
+* those few values printf is asked for the fewest significant
+* digits that read back, found by bisection.
+************************************************************/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <math.h>
+#include <unistd.h>
+#include "writer.h"
+
+/* 2^53: integers below this are exact in a double */
+# define EXACT_LIMIT 9007199254740992.0
+
+static const char digitPairs[] =
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+/* powers of ten that are exact in a double */
+static const double powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* A number f * 2^e, with the 64 bit f Grisu works on. */
+struct DiyFp {
+	uint64_t f;
+	int      e;
+};
+
+/* 10^k as the 64 bit f * 2^e nearest to it, for every eighth k */
+struct CachedPower {
+	uint64_t f;
+	int      e;
+	int      k;
+};
+
+static const struct CachedPower cachedPowers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220, -348 },
+	{ 0xbaaee17fa23ebf76ULL, -1193, -340 },
+	{ 0x8b16fb203055ac76ULL, -1166, -332 },
+	{ 0xcf42894a5dce35eaULL, -1140, -324 },
+	{ 0x9a6bb0aa55653b2dULL, -1113, -316 },
+	{ 0xe61acf033d1a45dfULL, -1087, -308 },
+	{ 0xab70fe17c79ac6caULL, -1060, -300 },
+	{ 0xff77b1fcbebcdc4fULL, -1034, -292 },
+	{ 0xbe5691ef416bd60cULL, -1007, -284 },
+	{ 0x8dd01fad907ffc3cULL,  -980, -276 },
+	{ 0xd3515c2831559a83ULL,  -954, -268 },
+	{ 0x9d71ac8fada6c9b5ULL,  -927, -260 },
+	{ 0xea9c227723ee8bcbULL,  -901, -252 },
+	{ 0xaecc49914078536dULL,  -874, -244 },
+	{ 0x823c12795db6ce57ULL,  -847, -236 },
+	{ 0xc21094364dfb5637ULL,  -821, -228 },
+	{ 0x9096ea6f3848984fULL,  -794, -220 },
+	{ 0xd77485cb25823ac7ULL,  -768, -212 },
+	{ 0xa086cfcd97bf97f4ULL,  -741, -204 },
+	{ 0xef340a98172aace5ULL,  -715, -196 },
+	{ 0xb23867fb2a35b28eULL,  -688, -188 },
+	{ 0x84c8d4dfd2c63f3bULL,  -661, -180 },
+	{ 0xc5dd44271ad3cdbaULL,  -635, -172 },
+	{ 0x936b9fcebb25c996ULL,  -608, -164 },
+	{ 0xdbac6c247d62a584ULL,  -582, -156 },
+	{ 0xa3ab66580d5fdaf6ULL,  -555, -148 },
+	{ 0xf3e2f893dec3f126ULL,  -529, -140 },
+	{ 0xb5b5ada8aaff80b8ULL,  -502, -132 },
+	{ 0x87625f056c7c4a8bULL,  -475, -124 },
+	{ 0xc9bcff6034c13053ULL,  -449, -116 },
+	{ 0x964e858c91ba2655ULL,  -422, -108 },
+	{ 0xdff9772470297ebdULL,  -396, -100 },
+	{ 0xa6dfbd9fb8e5b88fULL,  -369,  -92 },
+	{ 0xf8a95fcf88747d94ULL,  -343,  -84 },
+	{ 0xb94470938fa89bcfULL,  -316,  -76 },
+	{ 0x8a08f0f8bf0f156bULL,  -289,  -68 },
+	{ 0xcdb02555653131b6ULL,  -263,  -60 },
+	{ 0x993fe2c6d07b7facULL,  -236,  -52 },
+	{ 0xe45c10c42a2b3b06ULL,  -210,  -44 },
+	{ 0xaa242499697392d3ULL,  -183,  -36 },
+	{ 0xfd87b5f28300ca0eULL,  -157,  -28 },
+	{ 0xbce5086492111aebULL,  -130,  -20 },
+	{ 0x8cbccc096f5088ccULL,  -103,  -12 },
+	{ 0xd1b71758e219652cULL,   -77,   -4 },
+	{ 0x9c40000000000000ULL,   -50,    4 },
+	{ 0xe8d4a51000000000ULL,   -24,   12 },
+	{ 0xad78ebc5ac620000ULL,     3,   20 },
+	{ 0x813f3978f8940984ULL,    30,   28 },
+	{ 0xc097ce7bc90715b3ULL,    56,   36 },
+	{ 0x8f7e32ce7bea5c70ULL,    83,   44 },
+	{ 0xd5d238a4abe98068ULL,   109,   52 },
+	{ 0x9f4f2726179a2245ULL,   136,   60 },
+	{ 0xed63a231d4c4fb27ULL,   162,   68 },
+	{ 0xb0de65388cc8ada8ULL,   189,   76 },
+	{ 0x83c7088e1aab65dbULL,   216,   84 },
+	{ 0xc45d1df942711d9aULL,   242,   92 },
+	{ 0x924d692ca61be758ULL,   269,  100 },
+	{ 0xda01ee641a708deaULL,   295,  108 },
+	{ 0xa26da3999aef774aULL,   322,  116 },
+	{ 0xf209787bb47d6b85ULL,   348,  124 },
+	{ 0xb454e4a179dd1877ULL,   375,  132 },
+	{ 0x865b86925b9bc5c2ULL,   402,  140 },
+	{ 0xc83553c5c8965d3dULL,   428,  148 },
+	{ 0x952ab45cfa97a0b3ULL,   455,  156 },
+	{ 0xde469fbd99a05fe3ULL,   481,  164 },
+	{ 0xa59bc234db398c25ULL,   508,  172 },
+	{ 0xf6c69a72a3989f5cULL,   534,  180 },
+	{ 0xb7dcbf5354e9beceULL,   561,  188 },
+	{ 0x88fcf317f22241e2ULL,   588,  196 },
+	{ 0xcc20ce9bd35c78a5ULL,   614,  204 },
+	{ 0x98165af37b2153dfULL,   641,  212 },
+	{ 0xe2a0b5dc971f303aULL,   667,  220 },
+	{ 0xa8d9d1535ce3b396ULL,   694,  228 },
+	{ 0xfb9b7cd9a4a7443cULL,   720,  236 },
+	{ 0xbb764c4ca7a44410ULL,   747,  244 },
+	{ 0x8bab8eefb6409c1aULL,   774,  252 },
+	{ 0xd01fef10a657842cULL,   800,  260 },
+	{ 0x9b10a4e5e9913129ULL,   827,  268 },
+	{ 0xe7109bfba19c0c9dULL,   853,  276 },
+	{ 0xac2820d9623bf429ULL,   880,  284 },
+	{ 0x80444b5e7aa7cf85ULL,   907,  292 },
+	{ 0xbf21e44003acdd2dULL,   933,  300 },
+	{ 0x8e679c2f5e44ff8fULL,   960,  308 },
+	{ 0xd433179d9c8cb841ULL,   986,  316 },
+	{ 0x9e19db92b4e31ba9ULL,  1013,  324 },
+	{ 0xeb96bf6ebadf77d9ULL,  1039,  332 },
+	{ 0xaf87023b9bf0ee6bULL,  1066,  340 },
+};
+
+/* the k of cachedPowers[0], and the step between entries */
+# define CACHED_POWER_FIRST -348
+# define CACHED_POWER_STEP  8
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to start a writer on a file descriptor
+ param: w	the writer
+		fd	an open file descriptor
+ pre:	w is not null
+ post:	w has an empty internal buffer of WRITER_BUFFER bytes
+ */
+void initWriterFd(struct Writer *w, int fd)
+{
+    w->buf = malloc(WRITER_BUFFER);
+    assert(w->buf != 0);
+    w->cap = WRITER_BUFFER;
+    w->len = 0;
+    w->total = 0;
+    w->fd = fd;
+    w->error = 0;
+}
+
+/*
+ function to start a writer on a caller buffer
+ param: w	the writer
+		buf	the buffer
+		cap	the size of buf
+ pre:	w is not null
+ post:	output goes to buf, which the writer does not free
+ */
+void initWriterBuffer(struct Writer *w, char *buf, size_t cap)
+{
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->total = 0;
+    w->fd = -1;
+    w->error = 0;
+}
+
+/*
+ helper function to hand bytes to the file descriptor
+ param: w		the writer, on a file descriptor
+		bytes	the bytes
+		n		how many
+ post:	all n bytes are written, or w->error is set
+ */
+void _writeAll(struct Writer *w, const char *bytes, size_t n)
+{
+    while (n > 0 && w->error == 0) {
+        ssize_t done = write(w->fd, bytes, n);
+        if (done < 0) {
+            //a signal before anything was written is not a failure
+            if (errno != EINTR) {
+                w->error = errno;
+            }
+            continue;
+        }
+        bytes += done;
+        n -= done;
+    }
+}
+
+/*
+ function to flush and release a writer
+ param: w	the writer
+ pre:	w is not null
+ post:	returns the number of bytes written, or -1 with errno set
+ */
+long finishWriter(struct Writer *w)
+{
+    if (w->fd >= 0) {
+        _writeAll(w, w->buf, w->len);
+        free(w->buf);
+    }
+    w->buf = 0;
+    w->cap = w->len = 0;
+    if (w->error != 0) {
+        errno = w->error;
+        return -1;
+    }
+    return (long)w->total;
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ function to write raw bytes
+ param: w		the writer
+		bytes	the bytes
+		n		how many
+ pre:	w is not null
+ */
+void writeBytes(struct Writer *w, const void *bytes, size_t n)
+{
+    w->total += n;
+    //after a failure nothing more goes out, or a later write that fits
+    //would be spliced onto a torn record
+    if (w->error != 0) {
+        return;
+    }
+    if (w->cap - w->len >= n) {
+        memcpy(w->buf + w->len, bytes, n);
+        w->len += n;
+        return;
+    }
+    //a caller buffer cannot grow; keep counting so the caller learns the size
+    if (w->fd < 0) {
+        w->error = ENOSPC;
+        return;
+    }
+    _writeAll(w, w->buf, w->len);
+    w->len = 0;
+    //whatever is as large as the buffer skips it
+    if (n >= w->cap) {
+        _writeAll(w, bytes, n);
+    }
+    else {
+        memcpy(w->buf, bytes, n);
+        w->len = n;
+    }
+}
+
+/*
+ function to write one byte
+ param: w	the writer
+		c	the byte
+ */
+void writeChar(struct Writer *w, char c)
+{
+    if (w->len < w->cap && w->error == 0) {
+        w->buf[w->len++] = c;
+        w->total++;
+    }
+    else {
+        writeBytes(w, &c, 1);
+    }
+}
+
+/*
+ function to write a string without its terminator
+ param: w	the writer
+		s	the string
+ */
+void writeString(struct Writer *w, const char *s)
+{
+    writeBytes(w, s, strlen(s));
+}
+
+/*
+ function to write a string as a CSV field (RFC 4180)
+ param: w	the writer
+		s	the string, or null for an empty field
+ */
+void writeCsvField(struct Writer *w, const char *s)
+{
+    if (s == 0) {
+        return;
+    }
+    size_t n = strcspn(s, ",\"\r\n");
+    //most fields need no quotes and go out in one copy
+    if (s[n] == '\0') {
+        writeBytes(w, s, n);
+        return;
+    }
+    writeChar(w, '"');
+    for (const char *quote; (quote = strchr(s, '"')) != 0; s = quote + 1) {
+        //a quote inside the field is doubled
+        writeBytes(w, s, quote - s + 1);
+        writeChar(w, '"');
+    }
+    writeString(w, s);
+    writeChar(w, '"');
+}
+
+/*----------------------------------------------------------------------------*/
+/*
+ helper function to turn an unsigned number into digits
+ param: v	the number
+		end	one past the last byte of a buffer of at least 20 bytes
+ post:	returns where the digits start; they run up to end
+ */
+char *_digits(unsigned long long v, char *end)
+{
+    char *p = end;
+    while (v >= 100) {
+        unsigned i = (unsigned)(v % 100) * 2;
+        v /= 100;
+        *--p = digitPairs[i + 1];
+        *--p = digitPairs[i];
+    }
+    if (v >= 10) {
+        *--p = digitPairs[v * 2 + 1];
+        *--p = digitPairs[v * 2];
+    }
+    else {
+        *--p = (char)('0' + v);
+    }
+    return p;
+}
+
+/*
+ function to write an integer in decimal
+ param: w	the writer
+		v	the integer
+ */
+void writeInt(struct Writer *w, long long v)
+{
+    char tmp[24];
+    //negate as unsigned so the smallest long long works too
+    unsigned long long u = (v < 0) ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    char *p = _digits(u, tmp + sizeof(tmp));
+    if (v < 0) {
+        *--p = '-';
+    }
+    writeBytes(w, p, tmp + sizeof(tmp) - p);
+}
+
+/*
+ helper function to write a double that is m / 10^k exactly, as a fixed
+ point number with k decimals
+ param: w	the writer
+		m	the digits, m >= 0
+		k	the number of decimals
+ */
+void _writeFixed(struct Writer *w, unsigned long long m, int k)
+{
+    char tmp[48];
+    char *end = tmp + sizeof(tmp);
+    char *p = _digits(m, end);
+    //pad with zeros so there is a digit before the point
+    while (end - p <= k) {
+        *--p = '0';
+    }
+    if (k > 0) {
+        //shift the integer part left one byte to open a gap for the point
+        char *point = end - k;
+        memmove(p - 1, p, point - p);
+        p--;
+        point[-1] = '.';
+    }
+    writeBytes(w, p, end - p);
+}
+
+/*
+ helper function to multiply two DiyFps, keeping the top 64 bits rounded
+ */
+struct DiyFp _diyTimes(struct DiyFp x, struct DiyFp y)
+{
+    uint64_t a = x.f >> 32, b = x.f & 0xffffffffULL;
+    uint64_t c = y.f >> 32, d = y.f & 0xffffffffULL;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    //the middle words and a half to round with
+    uint64_t mid = (bd >> 32) + (ad & 0xffffffffULL) + (bc & 0xffffffffULL) + (1ULL << 31);
+    struct DiyFp r = { ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64 };
+    return r;
+}
+
+/*
+ helper function to shift a DiyFp left until its top bit is set
+ pre:	x.f is not 0
+ */
+struct DiyFp _diyNormalize(struct DiyFp x)
+{
+    int shift = __builtin_clzll(x.f);
+    x.f <<= shift;
+    x.e -= shift;
+    return x;
+}
+
+/*
+ helper function to move the last digit down while that brings it closer
+ to the value, then check that it is the only candidate that close
+ param: digits	the digits so far, the last one may change
+		n		how many
+		distHigh	distance from the upper bound of the interval to w
+		unsafe	width of the interval, widened by the rounding error
+		rest	distance from the upper bound to the digits
+		tenKappa	the value of one in the last digit
+		unit	the rounding error of the scaled numbers
+ post:	returns 1 if the digits are sure to be the closest shortest ones
+ */
+int _roundWeed(char *digits, int n, uint64_t distHigh, uint64_t unsafe,
+               uint64_t rest, uint64_t tenKappa, uint64_t unit)
+{
+    uint64_t small = distHigh - unit;
+    uint64_t big = distHigh + unit;
+    while (rest < small && unsafe - rest >= tenKappa
+           && (rest + tenKappa < small || small - rest >= rest + tenKappa - small)) {
+        digits[n - 1]--;
+        rest += tenKappa;
+    }
+    //a candidate that could be as close means the error hides the answer
+    if (rest < big && unsafe - rest >= tenKappa
+        && (rest + tenKappa < big || big - rest > rest + tenKappa - big)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe - 4 * unit;
+}
+
+/*
+ helper function to find the shortest digits of a positive finite double
+ (Grisu3, Loitsch 2010)
+ param: v		the value
+		digits	room for 18 digits
+		n		receives how many there are
+		exp		receives the power of ten of the last digit
+ post:	returns 1 with digits * 10^exp the shortest decimal that reads
+		back as v, or 0 if the 64 bit precision was not enough to tell
+ */
+int _grisu3(double v, char *digits, int *n, int *exp)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    uint64_t frac = bits & ((1ULL << 52) - 1);
+    int biased = (int)(bits >> 52) & 0x7ff;
+    struct DiyFp x = (biased == 0) ? (struct DiyFp){ frac, -1074 }
+                                   : (struct DiyFp){ frac | (1ULL << 52), biased - 1075 };
+    //the values halfway to the doubles on either side; the one below is
+    //closer at a power of two
+    struct DiyFp plus = _diyNormalize((struct DiyFp){ (x.f << 1) + 1, x.e - 1 });
+    struct DiyFp minus = (frac == 0 && biased > 1) ? (struct DiyFp){ (x.f << 2) - 1, x.e - 2 }
+                                                  : (struct DiyFp){ (x.f << 1) - 1, x.e - 1 };
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    struct DiyFp wv = _diyNormalize(x);
+
+    //a power of ten that brings the exponent into [-60, -32], so the
+    //integer part fits 32 bits and the fraction keeps enough of them
+    //ceil(e * log10(2)), rounded up by hand so writer.c needs no libm
+    double kf = (-60 - (wv.e + 64) + 64 - 1) * 0.30102999566398114;
+    int k = (int)kf;
+    k += (k < kf);
+    const struct CachedPower *c = &cachedPowers[(-CACHED_POWER_FIRST + k - 1) / CACHED_POWER_STEP + 1];
+    struct DiyFp ten = { c->f, c->e };
+    struct DiyFp sw = _diyTimes(wv, ten);
+    struct DiyFp low = _diyTimes(minus, ten);
+    struct DiyFp high = _diyTimes(plus, ten);
+
+    //each product may be off by one unit, so only what lies inside the
+    //narrowed interval is safe
+    uint64_t unit = 1;
+    uint64_t tooLow = low.f - unit, tooHigh = high.f + unit;
+    uint64_t unsafe = tooHigh - tooLow;
+    int shift = -sw.e;
+    uint64_t one = 1ULL << shift;
+    uint32_t integrals = (uint32_t)(tooHigh >> shift);
+    uint64_t fractionals = tooHigh & (one - 1);
+    uint32_t divisor = 1;
+    int kappa = (integrals == 0) ? 0 : 1;
+    while (integrals / divisor >= 10) {
+        divisor *= 10;
+        kappa++;
+    }
+    *n = 0;
+    //digits of the integer part, until what is left fits in the interval
+    while (kappa > 0) {
+        digits[(*n)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        kappa--;
+        uint64_t rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe) {
+            *exp = kappa - c->k;
+            return _roundWeed(digits, *n, tooHigh - sw.f, unsafe, rest,
+                              (uint64_t)divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+    //then of the fraction, with the error growing tenfold per digit
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe *= 10;
+        digits[(*n)++] = (char)('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        kappa--;
+        if (fractionals < unsafe) {
+            *exp = kappa - c->k;
+            return _roundWeed(digits, *n, (tooHigh - sw.f) * unit, unsafe,
+                              fractionals, one, unit);
+        }
+    }
+}
+
+/*
+ helper function to write digits * 10^exp the way printf's %g would at
+ a precision of as many digits
+ param: w		the writer
+		digits	the digits, the first one is not 0
+		n		how many
+		exp		the power of ten of the last digit
+ */
+void _writeDigits(struct Writer *w, char *digits, int n, int exp)
+{
+    //%g drops trailing zeros
+    while (n > 1 && digits[n - 1] == '0') {
+        n--;
+        exp++;
+    }
+    //the power of ten of the first digit decides between the two forms
+    int x = n - 1 + exp;
+    char tmp[48];
+    char *p = tmp;
+    if (x < -4 || x >= n) {
+        *p++ = digits[0];
+        if (n > 1) {
+            *p++ = '.';
+            memcpy(p, digits + 1, n - 1);
+            p += n - 1;
+        }
+        *p++ = 'e';
+        *p++ = (x < 0) ? '-' : '+';
+        int ax = (x < 0) ? -x : x;
+        //at least two digits, as printf does
+        if (ax < 10) {
+            *p++ = '0';
+        }
+        char num[8];
+        char *q = _digits((unsigned long long)ax, num + sizeof(num));
+        memcpy(p, q, num + sizeof(num) - q);
+        p += num + sizeof(num) - q;
+    }
+    else if (x < 0) {
+        //0.000ddd
+        *p++ = '0';
+        *p++ = '.';
+        for (int i = -1; i > x; i--) {
+            *p++ = '0';
+        }
+        memcpy(p, digits, n);
+        p += n;
+    }
+    else {
+        //ddd.ddd, x < n so there is at least one digit before the point
+        memcpy(p, digits, x + 1);
+        p += x + 1;
+        if (n > x + 1) {
+            *p++ = '.';
+            memcpy(p, digits + x + 1, n - x - 1);
+            p += n - x - 1;
+        }
+    }
+    writeBytes(w, tmp, p - tmp);
+}
+
+/*
+ function to write a double in the shortest form that reads back the same
+ param: w	the writer
+		v	the value
+ */
+void writeDouble(struct Writer *w, double v)
+{
+    //%g never needs more than 24 bytes here, but gcc sizes it for 1e308
+    char tmp[320];
+    //fewest and most significant digits the shortest form can have
+    int lo = 1, hi = 17;
+    //nan and inf are left to printf
+    if (v - v == 0) {
+        double mag = fabs(v);
+        //the sign is written apart so that -0 keeps it
+        if (signbit(v)) {
+            writeChar(w, '-');
+        }
+        int k;
+        for (k = 0; k < (int)(sizeof(powersOf10) / sizeof(powersOf10[0])); k++) {
+            double scaled = mag * powersOf10[k];
+            if (scaled >= EXACT_LIMIT) {
+                break;
+            }
+            //scaled was rounded once, so the nearest k decimals are m - 1, m or m + 1
+            unsigned long long m = (unsigned long long)(scaled + 0.5);
+            for (int d = 0; d < 3; d++) {
+                unsigned long long c = (d == 0) ? m : (d == 1) ? m + 1 : m - 1;
+                if (c == ~0ULL) {
+                    break;
+                }
+                //both are exact, so the division rounds the same as reading it back
+                if ((double)c / powersOf10[k] == mag) {
+                    _writeFixed(w, c, k);
+                    return;
+                }
+            }
+        }
+        if (mag != 0) {
+            char digits[20];
+            int n, exp;
+            if (_grisu3(mag, digits, &n, &exp)) {
+                _writeDigits(w, digits, n, exp);
+                return;
+            }
+        }
+        //every form of up to 15 digits was tried, unless mag is too small
+        //or too large for the loop to get to its digits
+        if (k > 0 && k < (int)(sizeof(powersOf10) / sizeof(powersOf10[0]))) {
+            lo = 16;
+        }
+        v = mag;
+    }
+    //the fewest digits that read back, by bisection; 17 always do
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        snprintf(tmp, sizeof(tmp), "%.*g", mid, v);
+        if (strtod(tmp, 0) == v) {
+            hi = mid;
+        }
+        else {
+            lo = mid + 1;
+        }
+    }
+    writeBytes(w, tmp, snprintf(tmp, sizeof(tmp), "%.*g", lo, v));
+}
@@ -0,0 +1,56 @@
+/*
+  File: writer.h
+  Buffered output shared by the export functions of the containers.  A
+  writer collects bytes in a large buffer and hands them to a file
+  descriptor a buffer at a time, or fills a buffer owned by the caller.
+  Numbers are formatted by hand: integers two digits at a time and doubles
+  in the shortest form that reads back to the same value (Grisu3), so an
+  integer costs a few nanoseconds and a double well under a printf call.
+
+  Errors are sticky: after the first failed write, or once a caller buffer
+  is full, later writes are dropped and finishWriter reports the failure.
+*/
+
+#ifndef __WRITER_H
+#define __WRITER_H
+
+#include <stddef.h>
+
+/* Size of the internal buffer of a writer on a file descriptor. */
+# ifndef WRITER_BUFFER
+# define WRITER_BUFFER (1 << 20)
+# endif
+
+/* Output formats of the export functions. */
+# define EXPORT_TEXT   0	/* one value per line */
+# define EXPORT_CSV    1	/* one record per line, fields split by commas */
+# define EXPORT_BINARY 2	/* raw values in the byte order of this machine */
+
+struct Writer {
+	char   *buf;
+	size_t  cap;
+	size_t  len;	/* bytes in buf not yet written out */
+	size_t  total;	/* bytes produced so far, including dropped ones */
+	int     fd;	/* -1 when filling a caller buffer */
+	int     error;	/* errno of the first failure, or 0 */
+};
+
+/* Write to fd through an internal buffer of WRITER_BUFFER bytes. */
+void initWriterFd(struct Writer *w, int fd);
+/* Write into buf, which holds cap bytes. */
+void initWriterBuffer(struct Writer *w, char *buf, size_t cap);
+/* Flush and release the writer.  Returns the number of bytes written, or
+ * -1 with errno set: ENOSPC if a caller buffer was too small, in which
+ * case w->total is the size it needed. */
+long finishWriter(struct Writer *w);
+
+void writeBytes(struct Writer *w, const void *bytes, size_t n);
+void writeChar(struct Writer *w, char c);
+void writeString(struct Writer *w, const char *s);
+/* s as one CSV field, quoted only when it holds a comma, quote or newline. */
+void writeCsvField(struct Writer *w, const char *s);
+void writeInt(struct Writer *w, long long v);
+/* The shortest decimal that reads back as v; nan and inf as in printf. */
+void writeDouble(struct Writer *w, double v);
+
+# endif